@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cassert>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common.hpp"
+#include "connector.hpp"
+#include "graph.hpp"
+#include "grp.hpp"
+#include "grp2graph.hpp"
+
+// Compares the unidirectional and the bidirectional search on the two-pin nets of an instance. 
+// Every net is searched in the empty graph, so that both engines solve the same problem. 
+// The paths must have the same length. 
+
+int main( int argc, char* argv[] )
+{
+    if( argc < 2 ) {
+        std::cerr << "Usage: " << argv[0] << " instance.gr [max_nets]\n";
+        return 1;
+    }
+
+    const std::string filename = argv[1];
+
+    const int max_nets = ( argc > 2 ) ? std::atoi( argv[2] ) : 10000;
+
+    std::ifstream file( filename, std::ios_base::openmode::_S_in );
+
+    if( !file ) {
+        std::cerr << "Unable to open file: " << filename << "\n";
+        return 1;
+    }
+
+    GlobalRoutingProblem problem;
+    problem.read( file );
+    file.close();
+
+    assert( problem.check() );
+
+    Graph graph = createGraphFromGlobalRoutingProblem( problem );
+
+    Connector connector( problem, graph );
+
+    // extract the two-pin nets 
+
+    struct TwoPinNet { int s; int t; int min_net_width; BoundingBox pin_box; };
+
+    std::vector<TwoPinNet> two_pin_nets;
+
+    for( const auto& net : problem.nets )
+    {
+        std::set<int> nodes;
+        for( const auto& pin : net.pins ) {
+            const auto tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+            nodes.insert( graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer ) );
+        }
+
+        if( nodes.size() != 2 ) continue;
+
+        const int s = *nodes.begin();
+        const int t = *nodes.rbegin();
+
+        int x1, y1, z1, x2, y2, z2;
+        std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( s );
+        std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( t );
+
+        const BoundingBox pin_box = {
+            std::min( x1, x2 ), std::max( x1, x2 ),
+            std::min( y1, y2 ), std::max( y1, y2 ),
+            std::min( z1, z2 ), std::max( z1, z2 ),
+        };
+
+        two_pin_nets.push_back( { s, t, net.minimum_width, pin_box } );
+
+        if( two_pin_nets.size() >= max_nets ) break;
+    }
+
+    std::cout << "Two-pin nets: " << two_pin_nets.size() << " of " << problem.nets.size() << nl;
+
+    // the search logs every net, which would dominate the measurement 
+    auto* clog_buffer = std::clog.rdbuf( nullptr );
+
+    SearchWorkspace unidirectional( graph.get_layout() );
+    SearchWorkspace bidirectional( graph.get_layout() );
+
+    double unidirectional_seconds = 0.;
+    double bidirectional_seconds  = 0.;
+
+    long total_length = 0;
+
+    for( const auto& net : two_pin_nets )
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        const auto forest = connector.create_search_forest( unidirectional, { net.s }, { net.t }, net.min_net_width, net.pin_box, Connector::initial_box_margin, true );
+        unidirectional_seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+
+        start_time = std::chrono::steady_clock::now();
+        const auto path = connector.create_bidirectional_path( bidirectional, net.s, net.t, net.min_net_width, net.pin_box, Connector::initial_box_margin, true );
+        bidirectional_seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+
+        // every edge has unit length in the empty graph 
+        if( forest.size() != path.size() ) {
+            std::clog.rdbuf( clog_buffer );
+            std::cerr << "Path lengths differ: " << forest.size() << " and " << path.size() << nl;
+            return 1;
+        }
+
+        total_length += path.size();
+    }
+
+    std::clog.rdbuf( clog_buffer );
+
+    std::cout << "Total length: " << total_length << nl;
+    std::cout << "Unidirectional expansions: " << unidirectional.expansions << "\t time: " << unidirectional_seconds << "s\n";
+    std::cout << "Bidirectional expansions:  " << bidirectional.expansions  << "\t time: " << bidirectional_seconds  << "s\n";
+    std::cout << "Ratio of expansions: " << (double)bidirectional.expansions / std::max( 1L, unidirectional.expansions ) << nl;
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#!/bin/bash
+#
+# Scaling benchmark on synthetic instances: sweeps the net count, the grid area, and the congestion 
+# one at a time, routes every instance with main.out, and prints one CSV line per run from its JSON report. 
+#
+# Usage: ./bench_scaling.sh [nets|grid|congestion ...] > scaling.csv
+#
+# The environment variables THREADS, SEEDS, and ROUNDS set the threads, the seeds of the instances, 
+# and the negotiation rounds of each run (default: 1, "1", and 20). 
+
+set -euo pipefail
+
+cd "$( dirname "$0" )"
+
+THREADS=${THREADS:-1}
+SEEDS=${SEEDS:-1}
+ROUNDS=${ROUNDS:-20}
+
+SWEEPS=${*:-nets grid congestion}
+
+make --quiet generate.out main.out ${CC:+"CC=$CC"} >&2
+
+WORKDIR=$( mktemp -d )
+trap 'rm -rf "$WORKDIR"' EXIT
+
+# value of a key at the top level of the report 
+value() { sed -n "s/^  \"$2\": \\([^,]*\\),\$/\\1/p" "$1"; }
+
+# seconds of a phase in the report 
+phase() { sed -n "s/.*\"name\": \"$2\", \"seconds\": \\([^,]*\\),.*/\\1/p" "$1"; }
+
+echo "sweep,seed,grid,layers,nets,tracks,clusters,pins,total_seconds,connect_seconds,negotiate_seconds,peak_rss_bytes,allocations,total_overflow,max_overflow,wirelength"
+
+# run SWEEP SEED X Y LAYERS NETS TRACKS CLUSTERS 
+run() {
+    local sweep=$1 seed=$2 x=$3 y=$4 layers=$5 nets=$6 tracks=$7 clusters=$8
+
+    local instance="$WORKDIR/instance.gr"
+    local report="$WORKDIR/report.json"
+    rm -f "$WORKDIR"/*
+
+    ./generate.out --seed "$seed" --grid "$x" "$y" --layers "$layers" --nets "$nets" --tracks "$tracks" \
+                   --clusters "$clusters" --adjustments 0.01 -o "$instance" 2> /dev/null
+
+    local pins
+    pins=$( awk 'NF == 4 && $1 ~ /^net/ { sum += $3 } END { print sum }' "$instance" )
+
+    ./main.out "$instance" --threads "$THREADS" --negotiation-rounds "$ROUNDS" --report "$report" > /dev/null 2>&1
+
+    echo "$sweep,$seed,${x}x$y,$layers,$nets,$tracks,$clusters,$pins,$( value "$report" total_seconds ),$( phase "$report" connect ),$( phase "$report" negotiate ),$( value "$report" peak_rss_bytes ),$( value "$report" allocations ),$( value "$report" total_overflow ),$( value "$report" max_overflow ),$( value "$report" wirelength )"
+}
+
+for seed in $SEEDS; do
+    for sweep in $SWEEPS; do
+        case $sweep in
+            # more nets on the same grid 
+            nets)       for nets in 2000 4000 8000 16000 32000 64000; do run nets "$seed" 256 256 6 "$nets" 10 0; done ;;
+            # larger grids with the same number of nets per tile 
+            grid)       for size in 64 128 256 512 1024; do run grid "$seed" "$size" "$size" 6 $(( size * size / 4 )) 10 0; done ;;
+            # fewer tracks and clustered nets on the same grid 
+            congestion) for tracks in 20 14 10 7 5; do run congestion "$seed" 256 256 6 16000 "$tracks" 8; done ;;
+            *)          echo "Unknown sweep: $sweep" >&2; exit 1 ;;
+        esac
+    done
+done
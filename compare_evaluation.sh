@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+# Compares the scores of evaluate.out with those of the contest script eval2008.pl on one instance. 
+# Without a solution file, the instance is routed with main.out first. 
+#
+# Usage: ./compare_evaluation.sh instance.gr[.gz] [instance.gr.solution]
+#
+# Requires `make evaluationscript` and, for the benchmark set, `make data`. 
+# Exits with 0 if the total overflow, the maximum overflow, and the wirelength agree, 
+# with 1 if they differ, and with 2 if the output of eval2008.pl cannot be parsed. 
+
+set -euo pipefail
+
+cd "$( dirname "$0" )"
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 instance.gr[.gz] [instance.gr.solution]" >&2
+    exit 2
+fi
+
+if [ ! -x eval2008/eval2008.pl ]; then
+    echo "eval2008/eval2008.pl is missing, run: make evaluationscript" >&2
+    exit 2
+fi
+
+make --quiet evaluate.out main.out ${CC:+"CC=$CC"} >&2
+
+WORKDIR=$( mktemp -d )
+trap 'rm -rf "$WORKDIR"' EXIT
+
+instance="$WORKDIR/$( basename "${1%.gz}" )"
+case $1 in
+    *.gz) gunzip -c "$1" > "$instance" ;;
+    *)    cp "$1" "$instance" ;;
+esac
+
+if [ $# -ge 2 ]; then
+    solution=$2
+else
+    ./main.out "$instance" ${THREADS:+--threads "$THREADS"} > /dev/null 2>&1
+    solution="$instance.solution"
+fi
+
+perl_output=$( perl eval2008/eval2008.pl "$instance" "$solution" 2>&1 || true )
+native_output=$( ./evaluate.out "$instance" "$solution" )
+
+# last integer on the first line that contains the pattern, ignoring case 
+last_number() { grep -i -m 1 -- "$2" <<< "$1" | grep -o '[0-9][0-9]*' | tail -n 1 || true; }
+
+native_total=$( sed -n 's/.*Total overflow: \([0-9]*\).*/\1/p' <<< "$native_output" )
+native_max=$( sed -n 's/.*max overflow: \([0-9]*\).*/\1/p' <<< "$native_output" )
+native_wirelength=$( sed -n 's/.*wirelength: \([0-9]*\).*/\1/p' <<< "$native_output" )
+
+perl_total=$( last_number "$perl_output" "total overflow" )
+perl_max=$( last_number "$perl_output" "max overflow" )
+perl_wirelength=$( last_number "$perl_output" "wirelength" )
+
+echo "$native_output"
+echo "$perl_output"
+
+if [ -z "$perl_total" ] || [ -z "$perl_max" ] || [ -z "$perl_wirelength" ]; then
+    echo "Unable to parse the output of eval2008.pl" >&2
+    exit 2
+fi
+
+status=0
+compare() {
+    if [ "$2" == "$3" ]; then
+        echo "$1: $2 (agree)"
+    else
+        echo "$1: evaluate.out $2, eval2008.pl $3 (DIFFER)"
+        status=1
+    fi
+}
+
+compare "total overflow" "$native_total" "$perl_total"
+compare "max overflow" "$native_max" "$perl_max"
+compare "wirelength" "$native_wirelength" "$perl_wirelength"
+
+exit $status
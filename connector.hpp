@@ -14,10 +14,20 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <cassert>
 #include <cmath>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <queue>
 #include <set>
+#include <span>
+#include <sstream>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -26,7 +36,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "graph.hpp"
 #include "grp.hpp"
+#include "grp2graph.hpp"
 #include "priority_queue.hpp"
+#include "projection.hpp"
+#include "scheduler.hpp"
+#include "solution_store.hpp"
+#include "steiner.hpp"
+#include "telemetry.hpp"
 
 
 // Models a 3D bounding box 
@@ -51,6 +67,436 @@ std::ostream& operator<<(std::ostream& os, const BoundingBox& bb) {
     return os;
 }
 
+// Enlarge the box by a margin in each direction, clipped to the grid 
+
+BoundingBox enlarge_box( const BoundingBox& bb, int margin, const Grid& grid )
+{
+    assert( margin >= 0 );
+    return {
+        std::max( bb.minx - margin, 0 ), std::min( bb.maxx + margin, grid.x_grids - 1 ),
+        std::max( bb.miny - margin, 0 ), std::min( bb.maxy + margin, grid.y_grids - 1 ),
+        std::max( bb.minz - margin, 0 ), std::min( bb.maxz + margin, grid.layers  - 1 ),
+    };
+}
+
+bool is_inside_box( const BoundingBox& bb, int x, int y, int z )
+{
+    return not( bb.minx > x or bb.maxx < x or bb.miny > y or bb.maxy < y or bb.minz > z or bb.maxz < z );
+}
+
+bool covers_grid( const BoundingBox& bb, const Grid& grid )
+{
+    return bb.minx == 0 and bb.maxx == grid.x_grids - 1 
+       and bb.miny == 0 and bb.maxy == grid.y_grids - 1 
+       and bb.minz == 0 and bb.maxz == grid.layers  - 1;
+}
+
+long count_box_nodes( const BoundingBox& bb )
+{
+    return long( bb.maxx - bb.minx + 1 ) * ( bb.maxy - bb.miny + 1 ) * ( bb.maxz - bb.minz + 1 );
+}
+
+
+
+// Options of the router 
+
+struct RoutingOptions
+{
+    // number of threads that route nets concurrently 
+    int num_threads = 1;
+
+    // produce the same solution for any number of threads 
+    bool deterministic = false;
+
+    // limits of the rip-up and reroute loop after the initial routing 
+    // NOTE: the time limit is ignored in deterministic mode 
+    int    negotiation_rounds  = 20;
+    double negotiation_seconds = 300.;
+
+    // try L- and Z-shaped paths for two-pin connections before the maze search 
+    bool pattern_routing = true;
+
+    // split nets with more than two pins into two-pin segments along a Steiner tree 
+    bool steiner_decomposition = true;
+
+    // route on the projection onto a single layer, and then assign the layers 
+    bool projected = false;
+
+    // If positive, long two-pin connections are first routed on a grid of super-tiles of this size, 
+    // and the search is limited to the corridor of super-tiles around the coarse route. 
+    int coarse_tile_size = 0;
+
+    // Searches in boxes with at most this many nodes keep their labels in a compact array for the box. 
+    // Larger searches use the labels of the whole graph. 
+    int local_search_nodes = 1 << 15;
+
+    // use the plain search kernel, which decodes the position of every neighbor, 
+    // as a reference for differential testing of the stride-based kernel 
+    bool reference_kernel = false;
+
+    // check that the final solution consists of trees that connect the pins of each net 
+    bool verify = false;
+};
+
+
+
+// The label of a node in a search. 
+// All fields that a visit reads or writes are kept together in one record. 
+
+struct NodeLabel
+{
+    int   queued         = -1;
+    int   settled        = -1;
+    int   preceding_node = -1;
+    int   relevant_edge  = -1;
+    float distance       = std::numeric_limits<float>::quiet_NaN();
+};
+
+
+
+// Labels of a search in one direction. 
+// 
+// The labels are indexed by slots. A search within a small box uses a compact array for the box only, 
+// where the slot of a node is its index relative to the lower corner of the box. 
+// Other searches use the array of the whole graph, where the slot of a node is its index. 
+// In either case, the slots are ordered as the node indices, so that ties in the queue are broken the same way. 
+// 
+// The labels carry the iteration in which they were written, so that no array needs to be cleared between searches. 
+
+struct SearchLabels
+{
+    Graph::Layout layout = {};
+
+    // labels of the whole graph, allocated on first use, and of the current small box 
+    std::vector<NodeLabel> global_labels;
+    std::vector<NodeLabel> local_labels;
+
+    // the labels in use, and the box of their slots 
+    NodeLabel*  labels = nullptr;
+    BoundingBox slot_box;
+    int         slot_stride_x = 0;
+    int         slot_stride_y = 0;
+
+    // the values in the queue are slots 
+    PriorityQueue<> pq;
+
+    // edges that were skipped because they leave the box or lack capacity, with the node they were reached from 
+    std::vector<std::pair<int,int>> frontier;
+
+    void allocate( const Graph::Layout& graph_layout ) { layout = graph_layout; }
+
+    bool is_allocated() const { return layout.dim_x > 0; }
+
+    bool is_local() const { return labels != global_labels.data(); }
+
+    int slot_of( int x, int y, int z ) const
+    {
+        assert( is_inside_box( slot_box, x, y, z ) );
+        return ( x - slot_box.minx ) * slot_stride_x + ( y - slot_box.miny ) * slot_stride_y + ( z - slot_box.minz );
+    }
+
+    int slot_of_node( int node ) const
+    {
+        const int x = node / layout.stride_x;
+        const int y = ( node - x * layout.stride_x ) / layout.stride_y;
+        const int z = node - x * layout.stride_x - y * layout.stride_y;
+        return slot_of( x, y, z );
+    }
+
+    void position_of_slot( int slot, int& x, int& y, int& z ) const
+    {
+        x = slot / slot_stride_x;
+        y = ( slot - x * slot_stride_x ) / slot_stride_y;
+        z = slot - x * slot_stride_x - y * slot_stride_y;
+        x += slot_box.minx;
+        y += slot_box.miny;
+        z += slot_box.minz;
+    }
+
+    int node_of_slot( int slot ) const
+    {
+        int x, y, z;
+        position_of_slot( slot, x, y, z );
+        return x * layout.stride_x + y * layout.stride_y + z;
+    }
+
+    NodeLabel& operator[]( int slot ) { return labels[slot]; }
+    const NodeLabel& operator[]( int slot ) const { return labels[slot]; }
+
+    NodeLabel& at_node( int node ) { return labels[ slot_of_node( node ) ]; }
+    const NodeLabel& at_node( int node ) const { return labels[ slot_of_node( node ) ]; }
+
+    // Start a search within the box. If the box has at most `max_local_nodes` nodes, then the compact array is used. 
+    void begin_search( const BoundingBox& box, int max_local_nodes );
+
+    // Continue the search of the given iteration within a larger box. 
+    // The labels of the search so far are moved to their slots in the new index space. 
+    void widen( const BoundingBox& box, int max_local_nodes, int iteration );
+
+  private:
+
+    void use_slots_of( const BoundingBox& box, int max_local_nodes );
+};
+
+void SearchLabels::use_slots_of( const BoundingBox& box, int max_local_nodes )
+{
+    assert( is_allocated() );
+
+    const long num_box_nodes = count_box_nodes( box );
+
+    if( num_box_nodes <= max_local_nodes ) 
+    {
+        if( local_labels.size() < num_box_nodes ) local_labels.resize( num_box_nodes );
+        labels        = local_labels.data();
+        slot_box      = box;
+        slot_stride_x = ( box.maxy - box.miny + 1 ) * ( box.maxz - box.minz + 1 );
+        slot_stride_y = ( box.maxz - box.minz + 1 );
+    } 
+    else 
+    {
+        if( global_labels.empty() ) global_labels.resize( long( layout.dim_x ) * layout.dim_y * layout.dim_z );
+        labels        = global_labels.data();
+        slot_box      = { 0, layout.dim_x-1, 0, layout.dim_y-1, 0, layout.dim_z-1 };
+        slot_stride_x = layout.stride_x;
+        slot_stride_y = layout.stride_y;
+    }
+}
+
+void SearchLabels::begin_search( const BoundingBox& box, int max_local_nodes )
+{
+    pq.clear();
+    frontier.clear();
+    use_slots_of( box, max_local_nodes );
+}
+
+void SearchLabels::widen( const BoundingBox& box, int max_local_nodes, int iteration )
+{
+    // nothing to move if the whole graph is indexed already 
+    if( not is_local() ) return;
+
+    // collect the labels of this search, and invalidate them in the old index space 
+    // NOTE: only the box is labeled, and the compact array may be reused for the new box 
+
+    std::vector<std::pair<int,NodeLabel>> moved;
+
+    const int old_num_slots = ( slot_box.maxx - slot_box.minx + 1 ) * slot_stride_x;
+
+    for( int slot = 0; slot < old_num_slots; slot++ ) 
+    {
+        if( labels[slot].queued != iteration ) continue;
+        moved.push_back( { node_of_slot( slot ), labels[slot] } );
+        labels[slot].queued  = -1;
+        labels[slot].settled = -1;
+    }
+
+    std::vector<PriorityQueue<>::Entry> entries;
+    while( not pq.empty() ) {
+        auto entry  = pq.pop();
+        entry.value = node_of_slot( entry.value );
+        entries.push_back( entry );
+    }
+
+    use_slots_of( box, max_local_nodes );
+
+    for( const auto& [ node, label ] : moved ) labels[ slot_of_node( node ) ] = label;
+
+    for( const auto& entry : entries ) pq.push( slot_of_node( entry.value ), entry.priority );
+}
+
+
+
+// State of a single search that the relaxation of edges needs, besides the labels 
+
+struct SearchContext
+{
+    // the search is restricted to this box, and to the corridor of the workspace if requested 
+    BoundingBox box;
+    bool use_corridor = false;
+
+    int   width_class = 0;
+    float capacity_penalty_factor = 0.;
+    int   iteration = 0;
+
+    // best joint path of a bidirectional search: its length, the edge where the two sides meet, and its end nodes on either side 
+    float best_length  = std::numeric_limits<float>::infinity();
+    int   best_edge    = -1;
+    int   best_node[2] = { -1, -1 };
+};
+
+
+
+// Layer policies of the search kernel. 
+// With a single layer, there are no edges in z direction, and the kernel does not consider them. 
+
+struct StackedLayers { static constexpr bool has_vias = true;  };
+struct SingleLayer   { static constexpr bool has_vias = false; };
+
+
+
+// Checks that edges form a tree that contains all targets, and whose leaves are all targets. 
+// 
+// The nodes of the tree are joined by union-find, so that a cycle shows up as an edge within one component, 
+// and the tree is connected if it has one more node than edges. All marks of nodes are stamped with 
+// the generation of the check, so that a check takes time in the size of the tree only. 
+
+class TreeChecker
+{
+  public:
+
+    // Returns an empty string if the edges form such a tree, and otherwise the reason why not. 
+    // The edges must be in increasing order. 
+    std::string check( const Graph& graph, std::span<const int> targets, std::span<const int> edgeindices );
+
+  private:
+
+    bool contains( int node ) const { return node_stamps[node] == generation; }
+
+    void insert( int node );
+
+    int find( int node );
+
+    std::vector<unsigned int> node_stamps;
+    std::vector<unsigned int> target_stamps;
+    std::vector<int>          parent;
+    std::vector<int>          degree;
+    unsigned int              generation = 0;
+
+    std::vector<int> nodes;
+};
+
+void TreeChecker::insert( int node )
+{
+    if( contains( node ) ) return;
+    node_stamps[node] = generation;
+    parent[node]      = node;
+    degree[node]      = 0;
+    nodes.push_back( node );
+}
+
+int TreeChecker::find( int node )
+{
+    assert( contains( node ) );
+    while( parent[node] != node ) {
+        parent[node] = parent[ parent[node] ];
+        node = parent[node];
+    }
+    return node;
+}
+
+std::string TreeChecker::check( const Graph& graph, std::span<const int> targets, std::span<const int> edgeindices )
+{
+    if( node_stamps.size() != graph.count_nodes() ) {
+        node_stamps.assign( graph.count_nodes(), 0 );
+        target_stamps.assign( graph.count_nodes(), 0 );
+        parent.resize( graph.count_nodes() );
+        degree.resize( graph.count_nodes() );
+        generation = 0;
+    }
+
+    generation++;
+    // after the counter wraps around, all stamps are reset once 
+    if( generation == 0 ) {
+        std::fill( node_stamps.begin(), node_stamps.end(), 0 );
+        std::fill( target_stamps.begin(), target_stamps.end(), 0 );
+        generation = 1;
+    }
+
+    nodes.clear();
+
+    for( int i = 1; i < edgeindices.size(); i++ ) {
+        if( edgeindices[i-1] >= edgeindices[i] ) return "edges are not in increasing order";
+    }
+
+    // without edges, all targets must be on the same tile 
+    if( edgeindices.empty() )
+    {
+        for( const int t : targets ) {
+            const auto [ tx, ty, tz ] = graph.get_position_from_nodeindex( t );
+            const auto [ sx, sy, sz ] = graph.get_position_from_nodeindex( targets.front() );
+            if( tx != sx or ty != sy ) return "targets on different tiles without edges";
+        }
+        return "";
+    }
+
+    for( const int e : edgeindices )
+    {
+        if( e < 0 or e >= graph.count_edges() ) return "edge index out of range";
+
+        const auto [ a, b ] = graph.get_nodes_of_edge( e );
+
+        insert( a );
+        insert( b );
+        degree[a]++;
+        degree[b]++;
+
+        const int root_a = find( a );
+        const int root_b = find( b );
+        if( root_a == root_b ) return "cycle";
+        parent[root_a] = root_b;
+    }
+
+    if( nodes.size() != edgeindices.size() + 1 ) return "not connected";
+
+    for( const int t : targets ) {
+        if( not contains( t ) ) return "target not on the tree";
+        target_stamps[t] = generation;
+    }
+
+    for( const int node : nodes ) {
+        if( degree[node] == 1 and target_stamps[node] != generation ) return "leaf that is not a target";
+    }
+
+    return "";
+}
+
+
+
+// Search state of a single thread. 
+// Each routing thread owns one workspace, so that searches can run concurrently. 
+
+struct SearchWorkspace
+{
+    SearchLabels forward;
+
+    // only used by the bidirectional search, allocated on first use 
+    SearchLabels backward;
+
+    int current_iteration = 0;
+
+    // set if the last search had to relax the capacity bounds 
+    bool emergency = false;
+
+    // statistics of the searches and fallbacks 
+    long   expansions           = 0;
+    int    box_expansions       = 0;
+    int    emergency_searches   = 0;
+    long   emergency_expansions = 0;
+    double emergency_seconds    = 0.;
+    int    pattern_attempts     = 0;
+    int    pattern_hits         = 0;
+    int    steiner_nets         = 0;
+    int    steiner_segments     = 0;
+    int    coarse_searches      = 0;
+    int    corridor_failures    = 0;
+
+    // super-tiles that the bidirectional search may enter, if not empty 
+    std::vector<char> corridor;
+
+    // edges collected from the paths of a search forest, allocated on first use 
+    StampedIndexSet edge_marks;
+
+    // checks the routed trees in debug builds, allocated on first use 
+    TreeChecker tree_checker;
+
+    // counters of the net that is currently routed 
+    NetRecord net_counters;
+
+    SearchWorkspace( const Graph::Layout& layout )
+    {
+        forward.allocate( layout );
+    }
+};
+
 
 
 // data structures for computing a solution 
@@ -59,530 +505,2119 @@ class Connector {
 private:
     const GlobalRoutingProblem& problem;
     const Graph& graph;
-    
-    std::vector<int> queued;
-    std::vector<int> preceding_node;
-    std::vector<int> relevant_edge;
-    
-    std::vector<float> distance;
 
-    PriorityQueue<> pq;
+    // strides and edge offsets of the graph, for the search kernel 
+    const Graph::Layout layout;
+
+    RoutingOptions options;
 
-    int current_iteration = -1;
+    std::vector<SearchWorkspace> workspaces;
+
+    // Routed nets are committed one at a time. 
+    // The searches of other threads read `aggregated_width` concurrently, 
+    // hence all accesses during routing go through atomic references. 
+    std::mutex commit_mutex;
 
     std::vector<int> aggregated_width;
+
+    // counters of the routing of every net 
+    Telemetry telemetry;
+
+    // accumulated costs of edges that were overflowed in earlier rounds of negotiation 
+    std::vector<float> history_cost;
+
+    // Grid of super-tiles: the capacity of a coarse edge is the sum of the capacities of all edges 
+    // between the two super-tiles, and its usage is the sum of their aggregated widths. 
+    // The coarse edges in x direction come first, then those in y direction. 
+    int coarse_x = 0;
+    int coarse_y = 0;
+    std::vector<int> coarse_capacity;
+    std::vector<int> coarse_usage;
+
+    int coarse_edge_of( int edgeindex ) const;
+
+    bool find_corridor( SearchWorkspace& ws, int s, int t, int min_net_width );
+
+    int load_aggregated_width( int edgeindex ) const;
+
+    int required_capacity_of_edge( int net_index, int edgeindex ) const;
+
+    double estimate_routing_cost( int net_index ) const;
+
+    // The routing functions return the edges of a net in increasing order, without duplicates. 
+
+    std::vector<int> route_net( SearchWorkspace& ws, int net_index, float capacity_penalty_factor = 10., bool allow_patterns = true );
+
+    std::vector<int> route_two_pins( SearchWorkspace& ws, int s, int t, int min_net_width, float capacity_penalty_factor, bool allow_patterns );
+
+    std::vector<int> route_steiner_segments( SearchWorkspace& ws, const std::vector<int>& nodes, int min_net_width, float capacity_penalty_factor, bool allow_patterns );
+
+    std::vector<int> extract_tree( std::span<const int> edgeindices, const std::vector<int>& nodes ) const;
+
+    SolutionStore connect_projected();
+
+    std::vector<int> assign_layers( int net_index, const Graph& planar_graph, std::span<const int> planar_edges ) const;
+
+    bool route_by_pattern( int s, int t, int min_net_width, std::vector<int>& edgeindices ) const;
+
+    bool fits_capacity( int net_index, std::span<const int> edgeindices ) const;
+
+    void commit_net( int net_index, std::span<const int> edgeindices );
+
+    void rip_up_net( int net_index, std::span<const int> edgeindices );
+
+    std::vector<int> find_overflowed_edges() const;
+
+    void log_search_statistics() const;
+
+    float edge_weight( int edgeindex, int width_class, bool respect_capacity, float capacity_penalty_factor ) const;
+
+    template<bool respect_capacity>
+    float edge_weight( int edgeindex, int width_class, float capacity_penalty_factor ) const;
+
+    // the same, for an edge whose lower end is on layer `z` 
+    template<bool respect_capacity>
+    float edge_weight( int edgeindex, int z, bool is_via, int width_class, float capacity_penalty_factor ) const;
+
+    // The search kernel: relax a single edge, or all edges at a node. 
+    // If `other` is given, then the search is bidirectional and `side` is the index of `labels`. 
+    // The versions with a runtime mode choose the instantiation for the mode and the number of layers. 
+
+    template<bool respect_capacity>
+    void relax_edge( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_node, int edgeindex ) const;
+
+    // relax the edge to a neighbor at the position (x,y,z), where the edge starts on layer `edge_z` 
+    template<bool respect_capacity>
+    void relax_neighbor( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, 
+                         int current_node, float current_distance, int other_node, int x, int y, int z, int edgeindex, int edge_z, bool is_via ) const;
+
+    template<bool respect_capacity, typename LayerPolicy>
+    void expand_node_reference( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot ) const;
+
+    template<bool respect_capacity, typename LayerPolicy>
+    void expand_node( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot ) const;
+
+    void relax_edge( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_node, int edgeindex, bool respect_capacity ) const;
+
+    void expand_node( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot, bool respect_capacity ) const;
+
+    // The distinct minimum widths of the nets, in increasing order, 
+    // and the required capacity of a net of each width class on each layer 
+    std::vector<int> width_classes;
+    std::vector<std::vector<int>> required_capacity_table;
+
+    // admissible[c] has the bit of an edge set if the edge can take another net of width class c 
+    std::vector<std::vector<std::uint64_t>> admissible;
+
+    int width_class_of( int min_net_width ) const;
+
+    bool is_admissible( int edgeindex, int width_class ) const;
+
+    void update_admissible( int edgeindex );
+
+    void update_label( SearchLabels& labels, int iteration, int from_node, int edgeindex, int to_slot, float new_distance ) const;
     
 public:
     static const int invalid_index;
 
-    Connector( GlobalRoutingProblem& problem, Graph& graph );
+    // how often a net is rerouted after a concurrent commit took its capacity 
+    static const int max_speculative_retries;
+
+    // number of nets routed concurrently against the same usage in deterministic mode 
+    static const int deterministic_wave_size;
+
+    // Margin of the search box around the pins. If no solution respecting the capacities is found, 
+    // the margin is multiplied by the growth factor, up to the maximum number of expansions. 
+    // Only then, the capacities are relaxed within the largest box. 
+    static const int initial_box_margin;
+    static const int box_growth_factor;
+    static const int max_box_expansions;
+
+    // number of bend positions tried for each orientation of Z-shaped patterns 
+    static const int pattern_z_bends;
+
+    // largest number of pins for which Steiner points are computed, larger nets use a spanning tree 
+    static const int steiner_max_degree;
+
+    // cost per unit of overflow during the layer assignment, compared to unit costs of wires and vias 
+    static const float layer_overflow_penalty;
+
+    // two-pin connections are routed on the coarse grid first if their pins are at least this many super-tiles apart 
+    static const int coarse_min_distance;
+
+    // growth of the history costs per track of overflow, and of the overflow penalty per round of negotiation 
+    static const float history_increment;
+    static const float penalty_growth;
+
+    Connector( GlobalRoutingProblem& problem, Graph& graph, RoutingOptions options = RoutingOptions() );
+
+    // Checks that the edges form a tree that connects the targets, which are the nodes of the pins of the net. 
+    // NOTE: the edges must be in increasing order 
+    bool verify_connector( TreeChecker& checker, int net_index, std::span<const int> targets, std::span<const int> edgeindices ) const;
+
+    bool verify_connector( int net_index, std::span<const int> targets, std::span<const int> edgeindices ) const;
+
+    // the number of nets whose edges do not form a tree connecting their pins 
+    int count_invalid_trees( const SolutionStore& trees ) const;
+
+    // Result of recomputing the usage of all edges from the routed trees 
+    struct CapacityAudit {
+        // edges whose recomputed usage differs from the aggregated width 
+        int mismatched_edges = 0;
+        // edges whose usage exceeds their capacity, and the nets that use any of them, in increasing order 
+        std::vector<int> overflowed_edges;
+        std::vector<int> overflowed_nets;
+        double seconds = 0.;
+    };
+
+    // Recomputes the usage with one thread per routing thread, and compares it with the aggregated width. 
+    CapacityAudit audit_capacities( const SolutionStore& trees ) const;
 
-    bool verify_connector( int net_index, const std::set<int> targets, const std::set<int>& edgeindices ) const;
+    // number of ranges of nets and of edges per thread in the audit 
+    static const int audit_ranges_per_thread;
 
-    bool verify_capacities( const std::vector<std::set<int>>& solutions, const std::vector<int>& aggregated_width ) const;
+    // the capacity that the committed nets use on each edge 
+    const std::vector<int>& get_aggregated_width() const { return aggregated_width; }
 
-    std::vector<std::set<int>> connect();
+    const Telemetry& get_telemetry() const { return telemetry; }
 
-    std::set<int> create_search_forest( 
-        const std::set<int>& S, const std::set<int>& T, 
+    SolutionStore connect();
+
+    void negotiate( SolutionStore& trees );
+
+    std::vector<int> create_search_forest( 
+        SearchWorkspace& ws,
+        const std::vector<int>& S, const std::vector<int>& T, 
+        int min_net_width, 
+        const BoundingBox& pin_box, int margin,
+        bool respect_capcity, float capacity_penalty_factor = 10. );
+
+    std::vector<int> create_bidirectional_path( 
+        SearchWorkspace& ws,
+        int s, int t, 
         int min_net_width, 
-        BoundingBox BB,
+        const BoundingBox& pin_box, int margin,
         bool respect_capcity, float capacity_penalty_factor = 10. );
 
 };
 
 const int Connector::invalid_index = -1;
 
+const int Connector::max_speculative_retries = 3;
+
+const int Connector::audit_ranges_per_thread = 8;
+
+const int Connector::deterministic_wave_size = 64;
+
+const int Connector::initial_box_margin = 10;
+
+const int Connector::box_growth_factor = 2;
+
+const int Connector::pattern_z_bends = 8;
+
+const int Connector::steiner_max_degree = 8;
+
+const float Connector::layer_overflow_penalty = 100.;
+
+const int Connector::coarse_min_distance = 3;
+
+const int Connector::max_box_expansions = 3;
+
+const float Connector::history_increment = 1.;
+
+const float Connector::penalty_growth = 1.5;
+
+
+
+
+
+
+
+
+
+
+
+
+
+Connector::Connector( GlobalRoutingProblem& problem, Graph& graph, RoutingOptions options )
+: 
+problem( problem ), 
+graph( graph ), 
+layout( graph.get_layout() ),
+options( options ),
+aggregated_width( graph.count_edges(), 0 ),
+telemetry( problem.nets.size() ),
+history_cost( graph.count_edges(), 0. )
+{
+    assert( options.num_threads >= 1 );
+    workspaces.reserve( options.num_threads );
+    for( int t = 0; t < options.num_threads; t++ ) 
+        workspaces.emplace_back( graph.get_layout() );
+
+    for( const auto& net : problem.nets ) width_classes.push_back( net.minimum_width );
+    std::sort( width_classes.begin(), width_classes.end() );
+    width_classes.erase( std::unique( width_classes.begin(), width_classes.end() ), width_classes.end() );
+
+    for( const int width : width_classes )
+    {
+        std::vector<int> required( problem.grid.layers );
+        for( int z = 0; z < problem.grid.layers; z++ ) 
+            required[z] = problem.dimension.minimum_spacing[z] + std::max( problem.dimension.minimum_width[z], width );
+        required_capacity_table.push_back( required );
+    }
+
+    admissible.assign( width_classes.size(), std::vector<std::uint64_t>( ( graph.count_edges() + 63 ) / 64, 0 ) );
+
+    for( int e = 0; e < graph.count_edges(); e++ ) update_admissible( e );
+
+    if( options.coarse_tile_size > 0 )
+    {
+        const int K = options.coarse_tile_size;
+
+        coarse_x = ( problem.grid.x_grids + K - 1 ) / K;
+        coarse_y = ( problem.grid.y_grids + K - 1 ) / K;
+
+        coarse_capacity.assign( 2 * coarse_x * coarse_y, 0 );
+        coarse_usage.assign( 2 * coarse_x * coarse_y, 0 );
+
+        for( int e = 0; e < graph.count_edges(); e++ )
+        {
+            const int c = coarse_edge_of( e );
+            if( c != invalid_index ) coarse_capacity[c] += graph.get_capacity( e );
+        }
+    }
+}
+
+
+
+// The coarse edge that contains an edge between two super-tiles, or the invalid index 
+
+int Connector::coarse_edge_of( int edgeindex ) const
+{
+    assert( options.coarse_tile_size > 0 );
+
+    const auto direction = graph.get_edge_direction( edgeindex );
+
+    if( direction == Graph::direction::z_plus ) return invalid_index;
+
+    const int K = options.coarse_tile_size;
+
+    int x1, y1, z1, x2, y2, z2;
+    const auto nodes = graph.get_nodes_of_edge( edgeindex );
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( nodes.first  );
+    std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( nodes.second );
+
+    const int X = std::min( x1, x2 ) / K;
+    const int Y = std::min( y1, y2 ) / K;
+
+    if( direction == Graph::direction::x_plus ) {
+        if( x1 / K == x2 / K ) return invalid_index;
+        return X * coarse_y + Y;
+    } else {
+        if( y1 / K == y2 / K ) return invalid_index;
+        return coarse_x * coarse_y + X * coarse_y + Y;
+    }
+}
+
+
+
+// Route a two-pin connection on the coarse grid and mark the corridor in the workspace: 
+// the super-tiles of the coarse route and their neighbors. 
+// Coarse edges cost one per super-tile, plus a penalty for the tracks that they would overflow. 
+// Returns false if the pins are too close for the coarse grid to help. 
+
+bool Connector::find_corridor( SearchWorkspace& ws, int s, int t, int min_net_width )
+{
+    assert( options.coarse_tile_size > 0 );
+
+    const int K = options.coarse_tile_size;
+
+    int x1, y1, z1, x2, y2, z2;
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( s );
+    std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( t );
+
+    const int source = ( x1 / K ) * coarse_y + y1 / K;
+    const int target = ( x2 / K ) * coarse_y + y2 / K;
+
+    if( std::abs( x1 / K - x2 / K ) + std::abs( y1 / K - y2 / K ) < coarse_min_distance ) return false;
+
+    ws.coarse_searches++;
+
+    // one track of the net on the lowest layer 
+    const int track = problem.dimension.minimum_spacing[0] + std::max( problem.dimension.minimum_width[0], min_net_width );
+
+    const int num_coarse_nodes = coarse_x * coarse_y;
+
+    std::vector<float> distance( num_coarse_nodes, std::numeric_limits<float>::infinity() );
+    std::vector<int>   preceding( num_coarse_nodes, -1 );
+
+    typedef std::pair<float,int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+
+    distance[source] = 0.;
+    pq.push( { 0., source } );
+
+    while( not pq.empty() )
+    {
+        const auto [ d, current ] = pq.top();
+        pq.pop();
+
+        if( d > distance[current] ) continue;
+        if( current == target ) break;
+
+        const int X = current / coarse_y;
+        const int Y = current % coarse_y;
+
+        const std::pair<int,int> moves[4] = { { X + 1, Y }, { X - 1, Y }, { X, Y + 1 }, { X, Y - 1 } };
+
+        for( const auto& move : moves )
+        {
+            if( move.first < 0 or move.first >= coarse_x or move.second < 0 or move.second >= coarse_y ) continue;
+
+            const int c = ( move.first != X ) 
+                        ? std::min( X, move.first ) * coarse_y + Y 
+                        : coarse_x * coarse_y + X * coarse_y + std::min( Y, move.second );
+
+            const int usage    = std::atomic_ref<int>( coarse_usage[c] ).load( std::memory_order_relaxed );
+            const int overflow = std::max( 0, usage + track - coarse_capacity[c] );
+
+            const float new_distance = d + 1. + 10. * overflow / track;
+
+            const int next = move.first * coarse_y + move.second;
+
+            if( new_distance < distance[next] ) {
+                distance[next]  = new_distance;
+                preceding[next] = current;
+                pq.push( { new_distance, next } );
+            }
+        }
+    }
+
+    assert( std::isfinite( distance[target] ) );
+
+    ws.corridor.assign( num_coarse_nodes, false );
+
+    for( int p = target; p != -1; p = preceding[p] )
+    {
+        const int X = p / coarse_y;
+        const int Y = p % coarse_y;
+        for( int dX = -1; dX <= 1; dX++ )
+        for( int dY = -1; dY <= 1; dY++ )
+            if( 0 <= X + dX and X + dX < coarse_x and 0 <= Y + dY and Y + dY < coarse_y ) 
+                ws.corridor[ ( X + dX ) * coarse_y + Y + dY ] = true;
+    }
+
+    return true;
+}
+
+
+
+int Connector::load_aggregated_width( int edgeindex ) const
+{
+    // std::atomic_ref needs a mutable referent, but we only load 
+    return std::atomic_ref<int>( const_cast<int&>( aggregated_width[edgeindex] ) ).load( std::memory_order_relaxed );
+}
+
+
+
+
+
+
+
+bool Connector::verify_connector( TreeChecker& checker, int net_index, std::span<const int> targets, std::span<const int> edgeindices ) const
+{
+    assert( 0 <= net_index && net_index < problem.nets.size() );
+
+    const std::string reason = checker.check( graph, targets, edgeindices );
+
+    if( not reason.empty() ) {
+        std::clog << "Invalid tree of net " << problem.nets[net_index].name << ": " << reason << nl;
+        return false;
+    }
+
+    return true;
+}
+
+bool Connector::verify_connector( int net_index, std::span<const int> targets, std::span<const int> edgeindices ) const
+{
+    TreeChecker checker;
+    return verify_connector( checker, net_index, targets, edgeindices );
+}
+
+int Connector::count_invalid_trees( const SolutionStore& trees ) const
+{
+    assert( trees.count_nets() == problem.nets.size() );
+
+    TreeChecker checker;
+    std::vector<int> pin_nodes;
+
+    int ret = 0;
+
+    for( int n = 0; n < trees.count_nets(); n++ )
+    {
+        pin_nodes.clear();
+        for( const auto& pin : problem.nets[n].pins ) {
+            const auto tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+            pin_nodes.push_back( graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer ) );
+        }
+
+        if( not verify_connector( checker, n, pin_nodes, trees.edges_of( n ) ) ) ret++;
+    }
+
+    return ret;
+}
+
+
+
+
+
+
+
+
+
+Connector::CapacityAudit Connector::audit_capacities( const SolutionStore& trees ) const
+{
+    assert( trees.count_nets() == problem.nets.size() );
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    WorkStealingScheduler scheduler( options.num_threads );
+
+    const int num_ranges = scheduler.count_threads() * audit_ranges_per_thread;
+
+    std::vector<int>    ranges( num_ranges );
+    std::vector<double> costs( num_ranges, 1. );
+    std::iota( ranges.begin(), ranges.end(), 0 );
+
+    // the start of range r when `count` items are split into contiguous ranges 
+    const auto range_start = [&]( int r, long count ) -> int { return count * r / num_ranges; };
+
+    // recompute the usage, the threads add to the same edges with atomic updates 
+
+    std::vector<int> usage( graph.count_edges(), 0 );
+
+    scheduler.run( ranges, costs, [&]( int, int r ) -> void {
+        for( int n = range_start( r, trees.count_nets() ); n < range_start( r + 1, trees.count_nets() ); n++ )
+        {
+            const int min_net_width = problem.nets[n].minimum_width;
+
+            for( const int e : trees.edges_of( n ) )
+            {
+                // edges in z direction do not consume capacity 
+                if( e >= layout.z_edges_offset ) continue;
+
+                // the layer is the remainder of the edge index in both planar blocks 
+                const int z = e % layout.dim_z;
+
+                const int required_capacity = std::max( min_net_width, problem.dimension.minimum_width[z] ) + problem.dimension.minimum_spacing[z];
+                assert( required_capacity == required_capacity_of_edge( n, e ) );
+
+                std::atomic_ref<int>( usage[e] ).fetch_add( required_capacity, std::memory_order_relaxed );
+            }
+        }
+    });
+
+    // compare with the aggregated widths and the capacities, each range collects its own results 
+
+    std::vector<int>              mismatched( num_ranges, 0 );
+    std::vector<std::vector<int>> overflowed( num_ranges );
+    std::vector<char>             is_overflowed( graph.count_edges(), false );
+
+    scheduler.run( ranges, costs, [&]( int, int r ) -> void {
+        for( int e = range_start( r, graph.count_edges() ); e < range_start( r + 1, graph.count_edges() ); e++ )
+        {
+            if( usage[e] != aggregated_width[e] ) mismatched[r]++;
+            if( usage[e] > graph.get_capacity(e) ) { overflowed[r].push_back( e ); is_overflowed[e] = true; }
+        }
+    });
+
+    CapacityAudit ret;
+
+    for( int r = 0; r < num_ranges; r++ ) {
+        ret.mismatched_edges += mismatched[r];
+        ret.overflowed_edges.insert( ret.overflowed_edges.end(), overflowed[r].begin(), overflowed[r].end() );
+        overflowed[r].clear();
+    }
+
+    // the nets on overflowed edges 
+
+    scheduler.run( ranges, costs, [&]( int, int r ) -> void {
+        for( int n = range_start( r, trees.count_nets() ); n < range_start( r + 1, trees.count_nets() ); n++ )
+        {
+            const auto tree = trees.edges_of( n );
+            if( std::any_of( tree.begin(), tree.end(), [&]( int e ) -> bool { return is_overflowed[e]; } ) ) overflowed[r].push_back( n );
+        }
+    });
+
+    for( int r = 0; r < num_ranges; r++ ) {
+        ret.overflowed_nets.insert( ret.overflowed_nets.end(), overflowed[r].begin(), overflowed[r].end() );
+    }
+
+    ret.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+
+    return ret;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+int Connector::required_capacity_of_edge( int net_index, int edgeindex ) const
+{
+    assert( 0 <= net_index && net_index < problem.nets.size() );
+    assert( 0 <= edgeindex && edgeindex < graph.count_edges() );
+
+    // edges in z direction do not consume capacity 
+    if( graph.get_edge_direction( edgeindex ) == Graph::direction::z_plus ) return 0;
+
+    const auto nodes = graph.get_nodes_of_edge( edgeindex );
+    
+    int x1,y1,z1;
+    int x2,y2,z2;
+    std::tie( x1,y1,z1 ) = graph.get_position_from_nodeindex( nodes.first  );
+    std::tie( x2,y2,z2 ) = graph.get_position_from_nodeindex( nodes.second );
+    
+    assert( z1 == z2 );
+    assert( x1 == x2+1 or x1 == x2-1 or y1 == y2+1 or y1 == y2-1 );
+    if( x1 != x2 ) assert( y1 == y2 );
+    if( y1 != y2 ) assert( x1 == x2 );
+    
+    const int min_net_width = problem.nets[net_index].minimum_width;
+
+    int required_capacity = std::max( min_net_width, problem.dimension.minimum_width[z1] ) + problem.dimension.minimum_spacing[z1];
+    
+    assert( required_capacity >= 0 );
+
+    return required_capacity;
+}
+
+
+
+double Connector::estimate_routing_cost( int net_index ) const
+{
+    // The search effort grows with the number of pins and the area of the bounding box. 
+    // This is only used to balance the work between threads. 
+    const auto& pins = problem.nets[net_index].pins;
+
+    if( pins.empty() ) return 0.;
+
+    int minx = std::numeric_limits<int>::max(), maxx = std::numeric_limits<int>::min();
+    int miny = std::numeric_limits<int>::max(), maxy = std::numeric_limits<int>::min();
+
+    for( const auto& pin : pins )
+    {
+        int tx, ty;
+        std::tie( tx, ty ) = problem.tile_of_coordinate( pin.x, pin.y );
+        minx = std::min( minx, tx ); maxx = std::max( maxx, tx );
+        miny = std::min( miny, ty ); maxy = std::max( maxy, ty );
+    }
+
+    const double hpwl = ( maxx - minx ) + ( maxy - miny );
+
+    return pins.size() * ( 1. + hpwl ) * ( 1. + hpwl );
+}
+
+
+
+std::vector<int> Connector::route_net( SearchWorkspace& ws, int n, float capacity_penalty_factor, bool allow_patterns )
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    ws.net_counters = NetRecord();
+    const long expansions_before = ws.expansions;
+
+    const auto& net = problem.nets[n];
+    
+    // list the tiles in the net 
+    const auto& pins = net.pins;
+
+    assert( pins.size() > 0 );
+
+    std::vector<int> nodes;
+    nodes.reserve( pins.size() );
+    
+    for( const auto& pin : pins )
+    {
+        std::pair<int,int> tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+
+        int nodeindex = graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer );
+
+        nodes.push_back( nodeindex );
+    }
+
+    {
+        std::sort(nodes.begin(), nodes.end());
+        auto last = std::unique(nodes.begin(), nodes.end());
+        nodes.erase(last, nodes.end());
+    }
+
+    // Bounding box of the pins 
+    BoundingBox pin_box = {
+        problem.grid.x_grids, 0,
+        problem.grid.y_grids, 0,
+        problem.grid.layers,  0,
+    };
+
+    for( auto nodeindex : nodes )
+    {
+        int x,y,z;
+        std::tie(x,y,z) = graph.get_position_from_nodeindex(nodeindex);
+
+        pin_box.maxx = std::max( x, pin_box.maxx );
+        pin_box.minx = std::min( x, pin_box.minx );
+        
+        pin_box.maxy = std::max( y, pin_box.maxy );
+        pin_box.miny = std::min( y, pin_box.miny );
+        
+        pin_box.minz = std::min( z, pin_box.minz );
+        pin_box.maxz = std::max( z, pin_box.maxz );
+        
+        assert( not( pin_box.minx > x or pin_box.maxx < x or pin_box.miny > y or pin_box.maxy < y or pin_box.minz > z or pin_box.maxz < z ) );
+    }
+
+    assert( 0 <= pin_box.minx and pin_box.minx <= pin_box.maxx and pin_box.maxx < problem.grid.x_grids );
+    assert( 0 <= pin_box.miny and pin_box.miny <= pin_box.maxy and pin_box.maxy < problem.grid.y_grids );
+    assert( 0 <= pin_box.minz and pin_box.minz <= pin_box.maxz and pin_box.maxz < problem.grid.layers  );
+    
+    // having collected all nodes, separate them into S and T
+
+    std::vector<int> S; 
+    std::vector<int> T; 
+
+    // int random_index = rand() % nodes.size();
+
+    int random_index = 0; // we assume that the pins are ordered to that the first one is at the center
+
+    for( int i = 0; i < nodes.size(); i++ )
+    {
+        if( random_index == i )
+            S.push_back( nodes[i] ); 
+        else 
+            T.push_back( nodes[i] );
+    }
+
+    // std::clog << nodes.size() <<' '<< random_index <<' '<< S.size() <<' '<< T.size() << '\n';
+    assert( S.size() + T.size() == nodes.size() );
+    assert( S.size() == 1 );
+    
+    // create the Steiner tree 
+
+    int min_net_width = problem.nets[n].minimum_width;
+
+    std::vector<int> edgeindices;
+
+    if( T.size() == 1 ) {
+
+        edgeindices = route_two_pins( ws, S.front(), T.front(), min_net_width, capacity_penalty_factor, allow_patterns );
+
+    } else if( T.size() >= 2 and options.steiner_decomposition ) {
+
+        edgeindices = route_steiner_segments( ws, nodes, min_net_width, capacity_penalty_factor, allow_patterns );
+
+    } else {
+
+        edgeindices = create_search_forest( ws, S, T, min_net_width, pin_box, initial_box_margin, true, capacity_penalty_factor );
+
+    }
+
+    assert( verify_connector( ws.tree_checker, n, nodes, edgeindices ) );
+
+    ws.net_counters.expansions  = ws.expansions - expansions_before;
+    ws.net_counters.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start_time ).count();
+    telemetry.record( n, ws.net_counters );
+
+    return edgeindices;
+}
+
+
+
+// Connect two nodes. The simple patterns are tried first, 
+// and otherwise the nodes are searched from both ends. 
+
+std::vector<int> Connector::route_two_pins( SearchWorkspace& ws, int s, int t, int min_net_width, float capacity_penalty_factor, bool allow_patterns )
+{
+    assert( s != t );
+
+    std::vector<int> edgeindices;
+
+    if( allow_patterns and options.pattern_routing )
+    {
+        ws.pattern_attempts++;
+
+        if( route_by_pattern( s, t, min_net_width, edgeindices ) )
+        {
+            ws.pattern_hits++;
+            ws.emergency = false;
+            return edgeindices;
+        }
+    }
+
+    int x1, y1, z1, x2, y2, z2;
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( s );
+    std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( t );
+
+    const BoundingBox pin_box = {
+        std::min( x1, x2 ), std::max( x1, x2 ),
+        std::min( y1, y2 ), std::max( y1, y2 ),
+        std::min( z1, z2 ), std::max( z1, z2 ),
+    };
+
+    // long connections are limited to the corridor of a coarse route first 
+    if( options.coarse_tile_size > 0 and not find_corridor( ws, s, t, min_net_width ) ) ws.corridor.clear();
+
+    return create_bidirectional_path( ws, s, t, min_net_width, pin_box, initial_box_margin, true, capacity_penalty_factor );
+}
+
+
+
+// Route a net with more than two pins along the segments of a Steiner tree of its pins in the plane. 
+// 
+// Each segment is routed as a two-pin connection in its own small box. 
+// A Steiner point is placed on the layer of the nearest pin. 
+// Pins above each other in the plane are connected directly. 
+// The union of the segments may contain cycles and detours, so a tree is extracted at the end. 
+
+std::vector<int> Connector::route_steiner_segments( SearchWorkspace& ws, const std::vector<int>& nodes, int min_net_width, float capacity_penalty_factor, bool allow_patterns )
+{
+    assert( nodes.size() >= 3 );
+
+    std::vector<PlanarPoint> points;
+    std::vector<int> point_nodes;
+    std::vector<std::pair<int,int>> segments;
+
+    for( const int nodeindex : nodes )
+    {
+        int x, y, z;
+        std::tie( x, y, z ) = graph.get_position_from_nodeindex( nodeindex );
+
+        const auto it = std::find( points.begin(), points.end(), PlanarPoint( x, y ) );
+
+        if( it != points.end() ) {
+            segments.push_back( { point_nodes[ it - points.begin() ], nodeindex } );
+        } else {
+            points.push_back( { x, y } );
+            point_nodes.push_back( nodeindex );
+        }
+    }
+
+    const int num_pins = points.size();
+
+    const auto tree = rectilinear_steiner_tree( points, steiner_max_degree );
+
+    for( int i = num_pins; i < points.size(); i++ )
+    {
+        int nearest = 0;
+        for( int j = 1; j < num_pins; j++ )
+            if( rectilinear_distance( points[i], points[j] ) < rectilinear_distance( points[i], points[nearest] ) ) 
+                nearest = j;
+
+        int x, y, z;
+        std::tie( x, y, z ) = graph.get_position_from_nodeindex( point_nodes[nearest] );
+
+        point_nodes.push_back( graph.get_nodeindex_from_position( points[i].first, points[i].second, z ) );
+    }
+
+    for( const auto& edge : tree ) segments.push_back( { point_nodes[edge.first], point_nodes[edge.second] } );
+
+    std::vector<int> edgeindices;
+
+    bool emergency = false;
+
+    for( const auto& segment : segments )
+    {
+        const auto segment_edges = route_two_pins( ws, segment.first, segment.second, min_net_width, capacity_penalty_factor, allow_patterns );
+        edgeindices.insert( edgeindices.end(), segment_edges.begin(), segment_edges.end() );
+        emergency = emergency or ws.emergency;
+    }
+
+    // segments may share edges 
+    std::sort( edgeindices.begin(), edgeindices.end() );
+    edgeindices.erase( std::unique( edgeindices.begin(), edgeindices.end() ), edgeindices.end() );
+
+    ws.emergency = emergency;
+    ws.steiner_nets++;
+    ws.steiner_segments += segments.size();
+
+    return extract_tree( edgeindices, nodes );
+}
+
+
+
+// Spanning tree of the connected subgraph given by the edges, 
+// without the branches that do not lead to any of the given nodes 
+
+std::vector<int> Connector::extract_tree( std::span<const int> edgeindices, const std::vector<int>& nodes ) const
+{
+    assert( not nodes.empty() );
+
+    std::map<int,std::vector<std::pair<int,int>>> neighbors;
+
+    for( const int edgeindex : edgeindices )
+    {
+        const auto edge = graph.get_nodes_of_edge( edgeindex );
+        neighbors[edge.first ].push_back( { edge.second, edgeindex } );
+        neighbors[edge.second].push_back( { edge.first,  edgeindex } );
+    }
+
+    // breadth-first search from the first node 
+
+    std::map<int,int> parent_edge;
+    std::vector<int> order;
+
+    parent_edge[ nodes[0] ] = -1;
+    order.push_back( nodes[0] );
+
+    for( int i = 0; i < order.size(); i++ )
+    {
+        for( const auto& neighbor : neighbors[ order[i] ] )
+        {
+            if( parent_edge.contains( neighbor.first ) ) continue;
+            parent_edge[ neighbor.first ] = neighbor.second;
+            order.push_back( neighbor.first );
+        }
+    }
+
+    // going backwards through the search order, keep the edges towards nodes whose subtree contains a node 
+
+    std::set<int> wanted( nodes.begin(), nodes.end() );
+
+    std::vector<int> ret;
+
+    for( int i = order.size() - 1; i > 0; i-- )
+    {
+        const int current = order[i];
+
+        if( not wanted.contains( current ) ) continue;
+
+        const int edgeindex = parent_edge[current];
+        ret.push_back( edgeindex );
+
+        const auto edge = graph.get_nodes_of_edge( edgeindex );
+        wanted.insert( edge.first == current ? edge.second : edge.first );
+    }
+
+    // every node has one parent edge, hence there are no duplicates 
+    std::sort( ret.begin(), ret.end() );
+
+    return ret;
+}
+
+
+
+// Try to connect two nodes by a straight, L-shaped, or Z-shaped path 
+// whose edges all have enough capacity. 
+// 
+// The horizontal and vertical segments of a pattern may each lie on any layer, 
+// and the bends are connected by via stacks. For each pattern, the layers of the segments 
+// are chosen by dynamic programming over the segments. The cheapest pattern is returned. 
+// If every pattern is blocked, then the function returns false. 
+
+bool Connector::route_by_pattern( int s, int t, int min_net_width, std::vector<int>& edgeindices ) const
+{
+    assert( s != t );
+
+    const int layers = problem.grid.layers;
+
+    const int width_class = width_class_of( min_net_width );
+
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    int x1, y1, z1, x2, y2, z2;
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( s );
+    std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( t );
+
+    // collect the patterns as sequences of bends in the plane 
+
+    std::vector<std::vector<std::pair<int,int>>> patterns;
+
+    if( x1 == x2 or y1 == y2 ) {
+        
+        if( x1 == x2 and y1 == y2 ) 
+            patterns.push_back( { { x1, y1 } } );
+        else 
+            patterns.push_back( { { x1, y1 }, { x2, y2 } } );
+
+    } else {
+
+        patterns.push_back( { { x1, y1 }, { x2, y1 }, { x2, y2 } } );
+        patterns.push_back( { { x1, y1 }, { x1, y2 }, { x2, y2 } } );
+
+        // the bends of the Z-shapes are spread evenly between the pins 
+
+        const int dx = std::abs( x2 - x1 );
+        const int dy = std::abs( y2 - y1 );
+
+        for( int b = 1; b <= pattern_z_bends; b++ )
+        {
+            const int offset = ( b * dx ) / ( pattern_z_bends + 1 );
+            if( offset == 0 or offset == dx ) continue;
+            const int xm = x1 + ( x2 > x1 ? offset : -offset );
+            if( patterns.back().size() == 4 and patterns.back()[1].first == xm ) continue;
+            patterns.push_back( { { x1, y1 }, { xm, y1 }, { xm, y2 }, { x2, y2 } } );
+        }
+
+        for( int b = 1; b <= pattern_z_bends; b++ )
+        {
+            const int offset = ( b * dy ) / ( pattern_z_bends + 1 );
+            if( offset == 0 or offset == dy ) continue;
+            const int ym = y1 + ( y2 > y1 ? offset : -offset );
+            if( patterns.back().size() == 4 and patterns.back()[1].second == ym ) continue;
+            patterns.push_back( { { x1, y1 }, { x1, ym }, { x2, ym }, { x2, y2 } } );
+        }
+
+    }
+
+    // Cost of a straight segment in the plane on layer z, or infinite if it is blocked. 
+    // If `edges` is given, then the edges of the chosen segment are collected instead, without checking the capacities again: 
+    // with several threads, another net may have taken the last capacity of an edge since the segment was chosen, 
+    // and stopping there would leave the path disconnected. 
+
+    const auto segment_cost = [&]( std::pair<int,int> from, std::pair<int,int> to, int z, std::vector<int>* edges ) -> float 
+    {
+        assert( from.first == to.first or from.second == to.second );
+
+        const int step_x = ( to.first  > from.first  ) - ( to.first  < from.first  );
+        const int step_y = ( to.second > from.second ) - ( to.second < from.second );
+
+        float cost = 0.;
+
+        for( int x = from.first, y = from.second; x != to.first or y != to.second; x += step_x, y += step_y )
+        {
+            const int edgeindex = graph.get_edgeindex_from_nodes( 
+                graph.get_nodeindex_from_position( x, y, z ), 
+                graph.get_nodeindex_from_position( x + step_x, y + step_y, z ) 
+            );
+
+            if( edges != nullptr ) {
+                edges->push_back( edgeindex );
+                continue;
+            }
+
+            cost += edge_weight( edgeindex, width_class, true, 0. );
+
+            if( not std::isfinite( cost ) ) return infinity;
+        }
+
+        return cost;
+    };
+
+    // Cost of the via stack at a bend between two layers. Vias always have capacity. 
+
+    const auto via_cost = [&]( std::pair<int,int> at, int from_z, int to_z, std::vector<int>* edges ) -> float 
+    {
+        float cost = 0.;
+
+        for( int z = std::min( from_z, to_z ); z < std::max( from_z, to_z ); z++ )
+        {
+            const int edgeindex = graph.get_edgeindex_from_nodes( 
+                graph.get_nodeindex_from_position( at.first, at.second, z     ), 
+                graph.get_nodeindex_from_position( at.first, at.second, z + 1 ) 
+            );
+
+            cost += edge_weight( edgeindex, width_class, true, 0. );
+
+            if( edges != nullptr ) edges->push_back( edgeindex );
+        }
+
+        assert( std::isfinite( cost ) );
+
+        return cost;
+    };
+
+    float best_cost = infinity;
+    int best_pattern = -1;
+    std::vector<int> best_layers;
+
+    for( int p = 0; p < patterns.size(); p++ )
+    {
+        const auto& bends = patterns[p];
+
+        const int num_segments = bends.size() - 1;
+
+        // cost[z]: cheapest cost to arrive at the current bend on layer z
+        // choice[i][z]: layer of the previous segment if segment i lies on layer z 
+
+        std::vector<float> cost( layers, infinity );
+        cost[z1] = 0.;
+
+        std::vector<std::vector<int>> choice( num_segments, std::vector<int>( layers, -1 ) );
+
+        for( int i = 0; i < num_segments; i++ )
+        {
+            std::vector<float> next_cost( layers, infinity );
+
+            const auto direction = ( bends[i].first != bends[i+1].first ) ? Graph::direction::x_plus : Graph::direction::y_plus;
+
+            for( int z = 0; z < layers; z++ )
+            {
+                if( not graph.is_direction_usable( z, direction ) ) continue;
+
+                const float segment = segment_cost( bends[i], bends[i+1], z, nullptr );
+                if( not std::isfinite( segment ) ) continue;
+
+                for( int previous_z = 0; previous_z < layers; previous_z++ )
+                {
+                    if( not std::isfinite( cost[previous_z] ) ) continue;
+                    const float candidate = cost[previous_z] + via_cost( bends[i], previous_z, z, nullptr ) + segment;
+                    if( candidate < next_cost[z] ) {
+                        next_cost[z]  = candidate;
+                        choice[i][z]  = previous_z;
+                    }
+                }
+            }
+
+            cost = next_cost;
+        }
+
+        // connect the last bend to the layer of the target 
+
+        int last_z = -1;
+        float total = infinity;
+
+        for( int z = 0; z < layers; z++ )
+        {
+            if( not std::isfinite( cost[z] ) ) continue;
+            const float candidate = cost[z] + via_cost( bends.back(), z, z2, nullptr );
+            if( candidate < total ) { total = candidate; last_z = z; }
+        }
+
+        if( not ( total < best_cost ) ) continue;
+
+        best_cost    = total;
+        best_pattern = p;
+
+        // layers of the segments, in order 
+        best_layers.assign( num_segments, -1 );
+        for( int i = num_segments - 1, z = last_z; i >= 0; i-- ) {
+            best_layers[i] = z;
+            z = choice[i][z];
+        }
+    }
+
+    if( best_pattern == -1 ) return false;
+
+    // collect the edges of the best pattern 
+
+    const auto& bends = patterns[best_pattern];
+
+    int current_z = z1;
+
+    for( int i = 0; i < best_layers.size(); i++ )
+    {
+        via_cost( bends[i], current_z, best_layers[i], &edgeindices );
+        segment_cost( bends[i], bends[i+1], best_layers[i], &edgeindices );
+        current_z = best_layers[i];
+    }
+
+    via_cost( bends.back(), current_z, z2, &edgeindices );
+
+    std::sort( edgeindices.begin(), edgeindices.end() );
+    edgeindices.erase( std::unique( edgeindices.begin(), edgeindices.end() ), edgeindices.end() );
+
+    return true;
+}
+
+
+
+bool Connector::fits_capacity( int net_index, std::span<const int> edgeindices ) const
+{
+    for( const auto edgeindex : edgeindices )
+    {
+        const int required_capacity = required_capacity_of_edge( net_index, edgeindex );
+
+        if( required_capacity == 0 ) continue;
+
+        if( load_aggregated_width( edgeindex ) + required_capacity > graph.get_capacity( edgeindex ) ) return false;
+    }
+    return true;
+}
+
+
+
+void Connector::commit_net( int net_index, std::span<const int> edgeindices )
+{
+    // update the aggregated widths 
+    for( const auto edgeindex : edgeindices )
+    {
+        const int required_capacity = required_capacity_of_edge( net_index, edgeindex );
+
+        if( required_capacity == 0 ) continue;
+        
+        std::atomic_ref<int> width( aggregated_width[edgeindex] );
+
+        assert( width.load() >= 0 );
+        
+        // assert( width.load() + required_capacity <= graph.get_capacity(edgeindex) );
+
+        width.fetch_add( required_capacity, std::memory_order_relaxed );
+
+        assert( width.load() >= 0 );
+
+        update_admissible( edgeindex );
+
+        if( options.coarse_tile_size > 0 ) {
+            const int c = coarse_edge_of( edgeindex );
+            if( c != invalid_index ) std::atomic_ref<int>( coarse_usage[c] ).fetch_add( required_capacity, std::memory_order_relaxed );
+        }
+        
+        // assert( width.load() <= graph.get_capacity( edgeindex ) );
+    }
+}
+
+
+
+void Connector::rip_up_net( int net_index, std::span<const int> edgeindices )
+{
+    for( const auto edgeindex : edgeindices )
+    {
+        const int required_capacity = required_capacity_of_edge( net_index, edgeindex );
+
+        if( required_capacity == 0 ) continue;
+        
+        std::atomic_ref<int> width( aggregated_width[edgeindex] );
+
+        width.fetch_sub( required_capacity, std::memory_order_relaxed );
+
+        assert( width.load() >= 0 );
+
+        update_admissible( edgeindex );
+
+        if( options.coarse_tile_size > 0 ) {
+            const int c = coarse_edge_of( edgeindex );
+            if( c != invalid_index ) std::atomic_ref<int>( coarse_usage[c] ).fetch_sub( required_capacity, std::memory_order_relaxed );
+        }
+    }
+}
+
+
+
+std::vector<int> Connector::find_overflowed_edges() const
+{
+    std::vector<int> ret;
+
+    for( int e = 0; e < graph.count_edges(); e++ )
+    {
+        if( aggregated_width[e] > graph.get_capacity(e) ) ret.push_back( e );
+    }
+
+    return ret;
+}
+
+
+
+void Connector::log_search_statistics() const
+{
+    if constexpr( log_level < log_level_summary ) return;
+
+    long   expansions           = 0;
+    int    box_expansions       = 0;
+    int    emergency_searches   = 0;
+    long   emergency_expansions = 0;
+    double emergency_seconds    = 0.;
+    int    pattern_attempts     = 0;
+    int    pattern_hits         = 0;
+    int    steiner_nets         = 0;
+    int    steiner_segments     = 0;
+    int    coarse_searches      = 0;
+    int    corridor_failures    = 0;
+
+    for( const auto& ws : workspaces ) {
+        expansions           += ws.expansions;
+        box_expansions       += ws.box_expansions;
+        emergency_searches   += ws.emergency_searches;
+        emergency_expansions += ws.emergency_expansions;
+        emergency_seconds    += ws.emergency_seconds;
+        pattern_attempts     += ws.pattern_attempts;
+        pattern_hits         += ws.pattern_hits;
+        steiner_nets         += ws.steiner_nets;
+        steiner_segments     += ws.steiner_segments;
+        coarse_searches      += ws.coarse_searches;
+        corridor_failures    += ws.corridor_failures;
+    }
+
+    if( coarse_searches > 0 )
+    std::clog << "Coarse routing: " << coarse_searches << " corridors\t left corridor: " << corridor_failures << nl;
+
+    if( steiner_nets > 0 )
+    std::clog << "Steiner decomposition: " << steiner_nets << " nets into " << steiner_segments << " segments" << nl;
+
+    if( pattern_attempts > 0 )
+    std::clog << "Pattern routing: " << pattern_hits << " of " << pattern_attempts << " two-pin connections\t hit rate: " << 100. * pattern_hits / pattern_attempts << "%" << nl;
+
+    std::clog << "Search expansions: " << expansions << nl;
+    std::clog << "Box expansions: " << box_expansions << "\t emergency searches: " << emergency_searches << "\t emergency expansions: " << emergency_expansions << "\t emergency time: " << emergency_seconds << "s" << nl;
+}
+
+
+
+// Route all nets on the projection of the grid onto a single layer, 
+// and then assign the planar trees to layers, one net after another. 
+// 
+// The planar routing uses a second connector on the projected problem, 
+// with the same options, including its negotiation. 
+
+SolutionStore Connector::connect_projected()
+{
+    auto projected_problem = project_to_2d( problem, graph );
+
+    assert( projected_problem.check() );
+
+    Graph projected_graph = createGraphFromGlobalRoutingProblem( projected_problem );
+
+    auto planar_options = options;
+    planar_options.projected = false;
+
+    SolutionStore planar_trees;
+    
+    {
+        Connector planar_connector( projected_problem, projected_graph, planar_options );
+        planar_trees = planar_connector.connect();
+        planar_connector.negotiate( planar_trees );
+    }
+
+    SolutionStore trees( problem.nets.size() );
+
+    int num_vias = 0;
+
+    for( int n = 0; n < problem.nets.size(); n++ )
+    {
+        if( problem.nets[n].pins.size() == 0 ) continue;
+
+        const auto tree = assign_layers( n, projected_graph, planar_trees.edges_of( n ) );
+
+        commit_net( n, tree );
+
+        for( const int e : tree ) 
+            if( graph.get_edge_direction( e ) == Graph::direction::z_plus ) 
+                num_vias++;
+
+        trees.assign( n, tree );
+    }
+
+    std::clog << "Layer assignment: " << num_vias << " vias" << nl;
+
+    return trees;
+}
+
+
+
+// Assign the edges of a planar tree to layers. 
+// 
+// The tree is rooted at the first pin. Going from the leaves towards the root, 
+// we compute for each node and each layer the cheapest cost of its subtree 
+// if the edge towards its parent lies on that layer. 
+// An edge on a layer costs its length, plus a penalty for the overflow that the net would cause there. 
+// Every change of layers between an edge and a child edge or pin costs one via per layer. 
+// This overestimates the vias if several children share a via stack, but keeps the costs separable. 
+// 
+// At the end, each node gets a via stack that spans the layers of its edges and pins. 
+
+std::vector<int> Connector::assign_layers( int net_index, const Graph& planar_graph, std::span<const int> planar_edges ) const
+{
+    const int layers = problem.grid.layers;
+
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    // pin layers at each planar node 
+
+    std::map<int,std::vector<int>> pin_layers;
+    int root = -1;
+
+    for( const auto& pin : problem.nets[net_index].pins )
+    {
+        const auto tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+        const int planar_node = planar_graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, 0 );
+        pin_layers[planar_node].push_back( pin.layer );
+        if( root == -1 ) root = planar_node;
+    }
+
+    assert( root != -1 );
+
+    // orient the tree by a breadth-first search from the root 
+
+    std::map<int,std::vector<std::pair<int,int>>> neighbors;
+
+    for( const int edgeindex : planar_edges )
+    {
+        const auto edge = planar_graph.get_nodes_of_edge( edgeindex );
+        neighbors[edge.first ].push_back( { edge.second, edgeindex } );
+        neighbors[edge.second].push_back( { edge.first,  edgeindex } );
+    }
+
+    std::vector<int> order = { root };
+    std::map<int,int> parent = { { root, -1 } };
+    std::map<int,std::vector<int>> children;
+
+    for( int i = 0; i < order.size(); i++ )
+    for( const auto& neighbor : neighbors[ order[i] ] )
+    {
+        if( parent.contains( neighbor.first ) ) continue;
+        parent[ neighbor.first ] = order[i];
+        children[ order[i] ].push_back( neighbor.first );
+        order.push_back( neighbor.first );
+    }
+
+    assert( order.size() == planar_edges.size() + 1 );
+
+    // the edge between a planar node and its parent on the given layer 
+
+    const auto edge_on_layer = [&]( int planar_node, int z ) -> int 
+    {
+        int x1, y1, z1, x2, y2, z2;
+        std::tie( x1, y1, z1 ) = planar_graph.get_position_from_nodeindex( planar_node );
+        std::tie( x2, y2, z2 ) = planar_graph.get_position_from_nodeindex( parent[planar_node] );
+        return graph.get_edgeindex_from_nodes( graph.get_nodeindex_from_position( x1, y1, z ), graph.get_nodeindex_from_position( x2, y2, z ) );
+    };
+
+    const auto wire_cost = [&]( int edgeindex ) -> float 
+    {
+        const int overflow = load_aggregated_width( edgeindex ) + required_capacity_of_edge( net_index, edgeindex ) - graph.get_capacity( edgeindex );
+        return 1. + history_cost[edgeindex] + layer_overflow_penalty * std::max( 0, overflow );
+    };
+
+    // cost[v][z]: cheapest cost of the subtree of v if the edge to the parent of v lies on layer z 
+    // through[v][z], through_layer[v][z]: the same, as seen from the parent on layer z, including the vias at v 
+
+    std::map<int,std::vector<float>> through;
+    std::map<int,std::vector<int>>   through_layer;
+
+    const auto subtree_cost = [&]( int v, int z ) -> float 
+    {
+        float cost = 0.;
+        for( const int c : children[v] ) cost += through[c][z];
+        if( pin_layers.contains( v ) )
+            for( const int pin_z : pin_layers[v] ) cost += std::abs( z - pin_z );
+        return cost;
+    };
+
+    for( int i = order.size() - 1; i > 0; i-- )
+    {
+        const int v = order[i];
+
+        std::vector<float> cost( layers, infinity );
+        for( int z = 0; z < layers; z++ ) {
+            const int edgeindex = edge_on_layer( v, z );
+            if( not graph.is_direction_usable( z, graph.get_edge_direction( edgeindex ) ) ) continue;
+            cost[z] = wire_cost( edgeindex ) + subtree_cost( v, z );
+        }
+
+        through[v].assign( layers, infinity );
+        through_layer[v].assign( layers, -1 );
+
+        for( int z = 0; z < layers; z++ )
+        for( int child_z = 0; child_z < layers; child_z++ )
+        {
+            const float candidate = cost[child_z] + std::abs( z - child_z );
+            if( candidate < through[v][z] ) { through[v][z] = candidate; through_layer[v][z] = child_z; }
+        }
+    }
+
+    // choose the layer of the via stack at the root, and then the layers of the edges from the top 
+
+    std::map<int,int> layer;
+
+    {
+        int best_z = 0;
+        for( int z = 1; z < layers; z++ ) 
+            if( subtree_cost( root, z ) < subtree_cost( root, best_z ) ) 
+                best_z = z;
+        layer[root] = best_z;
+    }
+
+    for( int i = 1; i < order.size(); i++ )
+    {
+        const int v = order[i];
+        layer[v] = through_layer[v][ layer[ parent[v] ] ];
+        assert( 0 <= layer[v] and layer[v] < layers );
+    }
+
+    // collect the wires and the via stacks 
+
+    std::vector<int> ret;
+
+    for( const int v : order )
+    {
+        if( v != root ) ret.push_back( edge_on_layer( v, layer[v] ) );
+
+        int min_z = layer[v];
+        int max_z = layer[v];
+        for( const int c : children[v] ) { min_z = std::min( min_z, layer[c] ); max_z = std::max( max_z, layer[c] ); }
+        if( pin_layers.contains( v ) )
+            for( const int pin_z : pin_layers[v] ) { min_z = std::min( min_z, pin_z ); max_z = std::max( max_z, pin_z ); }
+
+        int x, y, z;
+        std::tie( x, y, z ) = planar_graph.get_position_from_nodeindex( v );
+
+        for( int z = min_z; z < max_z; z++ )
+            ret.push_back( graph.get_edgeindex_from_nodes( graph.get_nodeindex_from_position( x, y, z ), graph.get_nodeindex_from_position( x, y, z + 1 ) ) );
+    }
+
+    // each wire and each via belongs to a single node of the planar tree 
+    std::sort( ret.begin(), ret.end() );
+    assert( std::adjacent_find( ret.begin(), ret.end() ) == ret.end() );
+
+    return ret;
+}
+
+
+
+SolutionStore Connector::connect()
+{
+    if( options.projected ) return connect_projected();
+
+    SolutionStore trees( problem.nets.size() );
+
+    // collect the nets with pins, and estimate the effort of routing them 
+
+    std::vector<int>    tasks;
+    std::vector<double> costs;
+
+    for( int n = 0; n < problem.nets.size(); n++ ) 
+    {
+        // if there are no pins, then skip 
+        if( problem.nets[n].pins.size() == 0 ) continue;
+
+        tasks.push_back( n );
+        costs.push_back( estimate_routing_cost( n ) );
+    }
+
+    WorkStealingScheduler scheduler( options.num_threads );
+
+    std::vector<double> busy_seconds( scheduler.count_threads(), 0. );
+    double              wall_seconds = 0.;
+    int                 steals       = 0;
+
+    const auto run_scheduler = [&]( const std::vector<int>& tasks, const std::vector<double>& costs, const std::function<void( int, int )>& work ) -> void {
+        scheduler.run( tasks, costs, work );
+        const auto utilization = scheduler.get_utilization();
+        for( int t = 0; t < utilization.size(); t++ ) busy_seconds[t] += utilization[t] * scheduler.get_wall_seconds();
+        wall_seconds += scheduler.get_wall_seconds();
+        steals       += scheduler.count_steals();
+    };
+
+    const auto log_net = [&]( int n ) -> void {
+        if constexpr( log_level < log_level_search ) return;
+        std::ostringstream message;
+        message << "Routing net\t " << n << "/" << problem.nets.size() << "\t pins: " << problem.nets[n].pins.size() << "\n";
+        std::clog << message.str();
+    };
+
+    if( not options.deterministic )
+    {
+
+        // Each net is routed speculatively against the current usage. 
+        // Before committing, we check that no other thread has used up the capacity in the meantime. 
+        // If it has, the net is rerouted. After too many attempts, the net is routed while holding 
+        // the commit lock, which cannot fail. 
+
+        const auto route_task = [&]( int thread_index, int n ) -> void {
+
+            SearchWorkspace& ws = workspaces[thread_index];
+
+            log_net( n );
+
+            for( int attempt = 0; attempt <= max_speculative_retries; attempt++ )
+            {
+                auto edgeindices = route_net( ws, n );
+
+                std::lock_guard<std::mutex> lock( commit_mutex );
+
+                // routes from emergency mode exceed the capacities anyways 
+                if( ws.emergency or fits_capacity( n, edgeindices ) )
+                {
+                    commit_net( n, edgeindices );
+                    trees.assign( n, edgeindices );
+                    return;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock( commit_mutex );
+            const auto edgeindices = route_net( ws, n );
+            commit_net( n, edgeindices );
+            trees.assign( n, edgeindices );
+        };
+
+        run_scheduler( tasks, costs, route_task );
+
+    } else {
+
+        // The nets are processed in waves of fixed size, independent of the number of threads. 
+        // All nets of a wave are routed concurrently against the usage at the start of the wave, 
+        // nothing is committed in the meantime. Then the routes are committed in the order of the nets. 
+        // A route that no longer fits because of an earlier commit in the same wave is rerouted 
+        // against the current usage. Every step depends only on the usage before it, 
+        // so the solution does not depend on the number of threads or on the timing. 
+
+        std::vector<std::vector<int>> speculative_trees( deterministic_wave_size );
+        std::vector<char>          speculative_emergency( deterministic_wave_size, false );
+
+        for( int wave_start = 0; wave_start < tasks.size(); wave_start += deterministic_wave_size )
+        {
+            const int wave_end = std::min<int>( wave_start + deterministic_wave_size, tasks.size() );
+
+            std::vector<int>    wave_slots;
+            std::vector<double> wave_costs;
+            for( int i = wave_start; i < wave_end; i++ ) {
+                wave_slots.push_back( i - wave_start );
+                wave_costs.push_back( costs[i] );
+            }
+
+            const auto speculate_task = [&]( int thread_index, int slot ) -> void {
+                SearchWorkspace& ws = workspaces[thread_index];
+                const int        n  = tasks[wave_start + slot];
+                log_net( n );
+                speculative_trees[slot]     = route_net( ws, n );
+                speculative_emergency[slot] = ws.emergency;
+            };
+
+            run_scheduler( wave_slots, wave_costs, speculate_task );
+
+            for( int i = wave_start; i < wave_end; i++ )
+            {
+                const int slot = i - wave_start;
+                const int n    = tasks[i];
+
+                if( not speculative_emergency[slot] and not fits_capacity( n, speculative_trees[slot] ) ) {
+                    speculative_trees[slot] = route_net( workspaces[0], n );
+                }
+
+                commit_net( n, speculative_trees[slot] );
+                trees.assign( n, speculative_trees[slot] );
+            }
+        }
+
+    }
+
+    if constexpr( log_level >= log_level_summary )
+    {
+        std::clog << "Routing threads: " << scheduler.count_threads() << "\t wall time: " << wall_seconds << "s\t steals: " << steals << nl;
+        
+        double average_utilization = 0.;
+        for( int t = 0; t < busy_seconds.size(); t++ ) 
+        {
+            const double utilization = ( wall_seconds > 0. ) ? busy_seconds[t] / wall_seconds : 0.;
+            std::clog << "Core utilization thread " << t << ": " << 100. * utilization << "%" << nl;
+            average_utilization += utilization / busy_seconds.size();
+        }
+        std::clog << "Core utilization average: " << 100. * average_utilization << "%" << nl;
+    }
+
+    log_search_statistics();
 
+    assert( audit_capacities( trees ).mismatched_edges == 0 );
 
+    return trees;
+}
 
 
 
 
 
+// Negotiated congestion, in the spirit of PathFinder. 
+// In every round, the nets that use an overflowed edge are ripped up and rerouted one after another. 
+// Each overflowed edge accumulates history costs, and the penalty for overflow grows from round to round, 
+// so that the nets negotiate which of them get the contested edges. 
+// Only the nets on overflowed edges are rerouted, not the full netlist. 
 
+void Connector::negotiate( SolutionStore& trees )
+{
+    assert( trees.count_nets() == problem.nets.size() );
 
+    const auto start_time = std::chrono::steady_clock::now();
 
+    float capacity_penalty_factor = 10.;
 
+    std::vector<char> is_overflowed( graph.count_edges(), false );
 
-Connector::Connector( GlobalRoutingProblem& problem, Graph& graph )
-: 
-problem( problem ), 
-graph( graph ), 
-queued( graph.count_nodes(), -1 ),
-preceding_node( graph.count_nodes(), -1 ),
-relevant_edge( graph.count_nodes(), -1 ),
-distance( graph.count_nodes(), std::numeric_limits<float>::quiet_NaN() ),
-current_iteration( 0 ),
-aggregated_width( graph.count_edges(), 0 )
-{
-}
+    for( int round = 1; round <= options.negotiation_rounds; round++ )
+    {
+        const auto overflowed_edges = find_overflowed_edges();
 
+        long total_overflow = 0;
+        for( const int e : overflowed_edges ) total_overflow += aggregated_width[e] - graph.get_capacity(e);
 
+        std::clog << "Negotiation round " << round << ": overflow " << total_overflow << " on " << overflowed_edges.size() << " edges";
 
+        if( overflowed_edges.empty() ) {
+            std::clog << nl;
+            break;
+        }
 
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
 
+        if( not options.deterministic and seconds > options.negotiation_seconds ) {
+            std::clog << ", time budget exhausted after " << seconds << "s" << nl;
+            break;
+        }
 
+        // The history costs grow with the overflow, measured in tracks of the layer 
+        for( const int e : overflowed_edges )
+        {
+            is_overflowed[e] = true;
 
-bool Connector::verify_connector( int net_index, const std::set<int> targets, const std::set<int>& edgeindices ) const
-{
-    std::set<int> nodes;
+            const int z = std::get<2>( graph.get_position_from_nodeindex( graph.get_nodes_of_edge(e).first ) );
 
+            const int pitch = std::max( 1, problem.dimension.minimum_width[z] + problem.dimension.minimum_spacing[z] );
 
-    // for( const auto edgeindex : edgeindices )
-    // {
-    //     const auto edge = graph.get_nodes_of_edge( edgeindex );
-    //     printf("(%d,%d) ", edge.first, edge.second );
-    // }
-    // printf("\n");
+            history_cost[e] += history_increment * ( aggregated_width[e] - graph.get_capacity(e) ) / (float)pitch;
+        }
 
-            
-    // if no edges, check that it is all on the same tile 
-    if( edgeindices.empty() )
-    {
-        const auto& pins = problem.nets[net_index].pins;
+        // collect the nets that use an overflowed edge 
+        std::vector<int> affected_nets;
 
-        if( pins.empty() ) return true;
+        for( int n = 0; n < trees.count_nets(); n++ )
+        for( const int e : trees.edges_of( n ) )
+        {
+            if( not is_overflowed[e] ) continue;
+            affected_nets.push_back( n );
+            break;
+        }
 
-        const auto s = pins.begin();
-        int sx, sy;
-        std::tie( sx, sy ) =  problem.tile_of_coordinate( s->x, s->y );
+        std::clog << ", rerouting " << affected_nets.size() << " nets" << nl;
 
-        for( const auto p : pins )
+        for( const int n : affected_nets )
         {
-            int tx, ty;
-            std::tie( tx, ty ) =  problem.tile_of_coordinate( p.x, p.y );
-        
-            assert( sx == tx && sy == ty );
-        };
+            rip_up_net( n, trees.edges_of( n ) );
+            // the patterns would ignore the history costs of their alternatives, hence the nets are searched 
+            const auto edgeindices = route_net( workspaces[0], n, capacity_penalty_factor, false );
+            commit_net( n, edgeindices );
+            trees.assign( n, edgeindices );
+        }
 
-        return true;
+        for( const int e : overflowed_edges ) is_overflowed[e] = false;
+
+        capacity_penalty_factor *= penalty_growth;
     }
 
-    // get all the node indices of the edges 
-    for( int edgeindex : edgeindices )
     {
-        const auto edge = graph.get_nodes_of_edge( edgeindex );
+        const auto overflowed_edges = find_overflowed_edges();
+        
+        long total_overflow = 0;
+        for( const int e : overflowed_edges ) total_overflow += aggregated_width[e] - graph.get_capacity(e);
 
-        nodes.insert( edge.first );
-        nodes.insert( edge.second );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+        
+        std::clog << "Negotiation finished: overflow " << total_overflow << " on " << overflowed_edges.size() << " edges after " << seconds << "s" << nl;
     }
 
-    const auto& pins = problem.nets[net_index].pins;
+    assert( audit_capacities( trees ).mismatched_edges == 0 );
+
+    log_search_statistics();
+}
 
-    // std::clog << "N/E/P " << nodes.size() << ' ' << edgeindices.size() << ' ' << pins.size() << std::endl;
 
-    // check that each pin is contained in the set of nodes 
-    for( const auto p : pins )
-    {
-        int tx, ty;
-        std::tie( tx, ty ) =  problem.tile_of_coordinate( p.x, p.y );
 
-        int pin_node = graph.get_nodeindex_from_position( tx, ty, p.layer );
 
-        assert( nodes.contains( pin_node ) );
-    };
 
-    
 
-    // check that the graph is not cyclic 
-    {
-        std::set<int> nodes_visited;
+// Weight of an edge for a net of the given width class. 
+// If the capacities are respected and the edge lacks capacity, then the weight is infinite. 
+// NOTE: each edge has unit length 
 
-        // pick some arbitrary node
-        int first_node = *(nodes.begin());
+float Connector::edge_weight( int edgeindex, int width_class, bool respect_capacity, float capacity_penalty_factor ) const
+{
+    return respect_capacity 
+         ? edge_weight<true >( edgeindex, width_class, capacity_penalty_factor ) 
+         : edge_weight<false>( edgeindex, width_class, capacity_penalty_factor );
+}
 
-        std::function<void(int,int)> 
-        // recursive_check();
-        
-        recursive_check = [&]( int current_node, int parent_node ) -> void {
+template<bool respect_capacity>
+float Connector::edge_weight( int edgeindex, int width_class, float capacity_penalty_factor ) const
+{
+    if constexpr ( respect_capacity ) 
+        return edge_weight<true>( edgeindex, 0, false, width_class, capacity_penalty_factor );
 
-            // std::clog << current_node << ' ' << parent_node << '\n';
+    const auto nodes = graph.get_nodes_of_edge( edgeindex );
+    int x1, y1, z1;
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( nodes.first );
 
-            assert( not nodes_visited.contains(current_node) );
+    const bool is_via = ( graph.get_edge_direction( edgeindex ) == Graph::direction::z_plus );
 
-            nodes_visited.insert( current_node );
+    return edge_weight<false>( edgeindex, z1, is_via, width_class, capacity_penalty_factor );
+}
 
-            const auto& adjacent_edges = graph.get_edgeindices_from_node( current_node );
+template<bool respect_capacity>
+float Connector::edge_weight( int edgeindex, int z, bool is_via, int width_class, float capacity_penalty_factor ) const
+{
+    // edges that were overflowed during negotiation carry their history costs 
+    
+    if constexpr ( respect_capacity ) 
+    {
+        if( not is_admissible( edgeindex, width_class ) ) return std::numeric_limits<float>::infinity();
 
-            int count_relevant_edges = 0;
+        return 1. + history_cost[edgeindex];
+    }
 
-            for( int edge_index : adjacent_edges )
-            {
-                if( not edgeindices.contains( edge_index ) ) continue;
+    assert( 0 <= z && z < problem.grid.layers );
 
-                const auto nodes_of_edge = graph.get_nodes_of_edge( edge_index );
+    float weight = 1. + history_cost[edgeindex]; 
+    
+    // the penalty counts the overflow that this net would cause 
+    // NOTE: edges with enough capacity have no penalty, so their weight is the same in both modes 
+    if( not is_via ) 
+    {
+        const int required_capacity        = required_capacity_table[width_class][z];
+        const int current_aggregated_width = load_aggregated_width( edgeindex );
+        const int current_edge_capacity    = graph.get_capacity( edgeindex );
 
-                int other_node = ( nodes_of_edge.first == current_node ) ? nodes_of_edge.second : nodes_of_edge.first;
-                assert( nodes_of_edge.first == current_node || nodes_of_edge.second == current_node );
-                assert( other_node != current_node );
-                
-                if( other_node == parent_node ) continue;
+        assert( 0 <= current_aggregated_width );
 
-                recursive_check( other_node, current_node );
+        weight += capacity_penalty_factor * std::max( 0.f, (float)current_aggregated_width + required_capacity - (float)current_edge_capacity );
+    }
+    
+    assert( std::isfinite( weight ) );
 
-                count_relevant_edges++;
-            }
+    return weight;
+}
 
-            // if no neighboring node except (possibly) parent, then we are in a terminal node 
-            if( count_relevant_edges == 0 ) assert( targets.contains( current_node ) );
 
-            // if happen to start at a terminal node, check there is at most one other edge 
-            if( parent_node == -1 && count_relevant_edges <= 1 ) assert( targets.contains( current_node ) );
 
-        };
+// Relax an edge from a settled node. 
+// Edges that leave the search area or lack capacity are put into the frontier: 
+// they become relevant once the search is widened. 
+// In a bidirectional search, every relaxed edge towards a node labeled by the other side is a candidate for the joint path. 
 
-        recursive_check( first_node, -1 );
+template<bool respect_capacity>
+void Connector::relax_edge( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_node, int edgeindex ) const
+{
+    const auto current_edge = graph.get_nodes_of_edge( edgeindex );
 
-        std::set<int> all_nodes;
-        // collect all nodes in the edges 
-        for( const auto e : edgeindices )
-        {
-            const auto nodes = graph.get_nodes_of_edge(e);
-            all_nodes.insert( nodes.first );
-            all_nodes.insert( nodes.second );
-        }
+    const int other_node = ( current_edge.first == current_node ) ? current_edge.second : current_edge.first;
 
-        assert( all_nodes == nodes_visited );
+    assert( current_edge.first == current_node or current_edge.second == current_node );
 
-        assert( all_nodes.size() == edgeindices.size() + 1 );
+    int x, y, z;
+    std::tie(x,y,z) = graph.get_position_from_nodeindex( other_node );
 
-    }
-    
-    
-    // check that the graph is connected
-    if(false)
-    { 
-        // we run over all the edges 
-        // make a queue of all edges and begin with any edge, and keep track of all edges visited 
-        
-        std::set<int> edges_queued;
-        edges_queued.insert( *(edgeindices.begin()) );
+    const bool is_via = ( graph.get_edge_direction( edgeindex ) == Graph::direction::z_plus );
 
-        std::set<int> edges_checked;
-        
-        while( ! edges_queued.empty() )
-        {
-            int edgeindex = *(edges_queued.begin());
-            assert( edges_queued.contains(edgeindex) );
-            edges_queued.erase(edgeindex);
-            assert( not edges_queued.contains(edgeindex) );
+    // the lower end of the edge is the first node 
+    const int edge_z = ( current_edge.first == other_node ) ? z : current_node % layout.dim_z;
 
-            // std::clog << "check " << edgeindex << '\n';
+    const float current_distance = labels.at_node( current_node ).distance;
 
-            assert( edgeindices.contains(edgeindex) );
+    relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, other_node, x, y, z, edgeindex, edge_z, is_via );
+}
 
-            // assert the popped edge is not contained twice 
+template<bool respect_capacity>
+void Connector::relax_neighbor( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, 
+                                int current_node, float current_distance, int other_node, int x, int y, int z, int edgeindex, int edge_z, bool is_via ) const
+{
+    assert( other_node == graph.get_nodeindex_from_position( x, y, z ) );
 
-            if( edges_queued.contains(edgeindex) )
-            {
-                for( const auto e : edges_queued ) 
-                    std::clog << e << std::endl;
-                std::clog << edgeindex << std::endl;
-            }
-            
+    const auto& box = context.box;
 
-            assert( not edges_queued.contains(edgeindex) );
+    if( x < box.minx or box.maxx < x or y < box.miny or box.maxy < y or z < box.minz or box.maxz < z 
+        or ( context.use_corridor and not ws.corridor[ ( x / options.coarse_tile_size ) * coarse_y + y / options.coarse_tile_size ] ) ) {
+        labels.frontier.push_back( { current_node, edgeindex } );
+        return;
+    }
 
-            // assert this edge has not been visited yet; every edge is visited only once 
-            // then insert in the set of checked edges  
-            assert( not edges_checked.contains(edgeindex) );
-            edges_checked.insert(edgeindex);
+    const float weight = edge_weight<respect_capacity>( edgeindex, edge_z, is_via, context.width_class, context.capacity_penalty_factor );
 
-            // collect the two nodes and extract the adjacent edges 
-            int nodes[2];
-            std::tie( nodes[0], nodes[1] ) = graph.get_nodes_of_edge(edgeindex);
+    if constexpr ( respect_capacity ) 
+    if( not std::isfinite( weight ) ) {
+        labels.frontier.push_back( { current_node, edgeindex } );
+        return;
+    }
 
-            const std::vector<int> adjacent_edges[2] = { graph.get_edgeindices_from_node( nodes[0] ), graph.get_edgeindices_from_node( nodes[1] ) };
-            
-            // for each adjacent edge
-            // - skip if not in the tree or if already visited
-            for( const auto& edges : adjacent_edges )
-            for( const int other_edge : edges )
-            {
-                // we skip if the current edge anyways
-                if( other_edge == edgeindex ) continue;
-                
-                // we skip what has already been checked 
-                if( edges_checked.contains(other_edge) ) continue;
-                
-                // we skip edges that are not in the subgraph
-                if( not edgeindices.contains(other_edge) ) continue;
+    const int other_slot = labels.slot_of( x, y, z );
 
-                // we skip edges that are already queued (because they were added when the preceding edge was processed)
-                if( edges_queued.contains( other_edge ) ) continue;
+    assert( other_slot == labels.slot_of_node( other_node ) );
 
-                assert( not edges_queued.contains( other_edge ) );
+    update_label( labels, context.iteration, current_node, edgeindex, other_slot, current_distance + weight );
 
-                edges_queued.insert( other_edge );
+    // the edges are undirected and have the same weight from either side 
+    if( other == nullptr ) return;
 
-                // edges_checked.insert(other_edge);
+    const auto& other_label = (*other)[ other->slot_of( x, y, z ) ];
 
-                assert( edges_queued.size() <= edgeindices.size() );
-            };
-            
+    if( other_label.queued == context.iteration )
+    {
+        const float length = current_distance + weight + other_label.distance;
+        if( length < context.best_length ) {
+            context.best_length       = length;
+            context.best_edge         = edgeindex;
+            context.best_node[side]   = current_node;
+            context.best_node[1-side] = other_node;
         }
-        assert( edges_queued.empty() );
-    
     }
-    
-    return true;
 }
 
 
 
+// The stride-based kernel decodes the position of the settled node once. 
+// The neighbors and the incident edges follow from the strides of the layout. 
 
+template<bool respect_capacity, typename LayerPolicy>
+void Connector::expand_node( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot ) const
+{
+    int x, y, z;
+    labels.position_of_slot( current_slot, x, y, z );
 
+    const int current_node = x * layout.stride_x + y * layout.stride_y + z;
 
+    const float current_distance = labels[current_slot].distance;
 
+    assert( current_node == graph.get_nodeindex_from_position( x, y, z ) );
 
+    // the same order of directions as in the reference kernel 
 
-bool Connector::verify_capacities( const std::vector<std::set<int>>& solutions, const std::vector<int>& aggregated_width ) const
-{
-    std::vector<int> remaining_capacities = graph.get_capacities();
-
-    for( int e = 0; e < graph.count_edges(); e++ ) 
+    if( graph.is_direction_usable( z, Graph::direction::x_plus ) ) 
     {
-        assert( remaining_capacities[e] == graph.get_capacity(e) );
-        assert( remaining_capacities[e] >= 0 );
-    } 
+        if( x < layout.dim_x-1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node + layout.stride_x, x+1, y, z, layout.x_edge( x,   y, z ), z, false );
+        if( x >= 1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node - layout.stride_x, x-1, y, z, layout.x_edge( x-1, y, z ), z, false );
+    }
 
-    for( int e = 0; e < graph.count_edges(); e++ )
+    if( graph.is_direction_usable( z, Graph::direction::y_plus ) ) 
     {
-        assert( graph.get_capacity(e)   >= 0 );
-        assert( aggregated_width[e]     >= 0 );
-        assert( remaining_capacities[e] >= 0 );
-        assert( aggregated_width[e] <= graph.get_capacity(e) );
+        if( y < layout.dim_y-1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node + layout.stride_y, x, y+1, z, layout.y_edge( x, y,   z ), z, false );
+        if( y >= 1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node - layout.stride_y, x, y-1, z, layout.y_edge( x, y-1, z ), z, false );
     }
 
-    for( int net_index = 0; net_index < solutions.size(); net_index++ )
+    if constexpr ( LayerPolicy::has_vias ) 
     {
-        const auto solution = solutions[net_index];
-        
-        for( const auto& e : solution )
-        {
-            const auto direction = graph.get_edge_direction(e);
-
-            if( direction == Graph::direction::z_plus ) continue;
-
-            const auto nodes = graph.get_nodes_of_edge( e );
-            int x1, y1, z1, x2, y2, z2;
-            std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( nodes.first  );
-            std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( nodes.second );
-    
-            assert( z1 == z2 );
-            assert( x1 == x2+1 or x1 == x2-1 or y1 == y2+1 or y1 == y2-1 );
-            if( x1 != x2 ) assert( y1 == y2 );
-            if( y1 != y2 ) assert( x1 == x2 );
-            
-            const auto min_spacing = problem.dimension.minimum_spacing[z1];
-            const auto min_width   = problem.dimension.minimum_width[z1];
-            
-            const auto min_net_width = problem.nets[net_index].minimum_width;
-
-            remaining_capacities[e] -= ( min_spacing + std::max(min_width,min_net_width) );
-
-            assert( remaining_capacities[e] >= 0 );
-        }
+        if( z < layout.dim_z-1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node + 1, x, y, z+1, layout.z_edge( x, y, z   ), z,   true );
+        if( z >= 1 ) 
+            relax_neighbor<respect_capacity>( ws, context, labels, other, side, current_node, current_distance, current_node - 1, x, y, z-1, layout.z_edge( x, y, z-1 ), z-1, true );
     }
-
-    for( int e = 0; e < graph.count_edges(); e++ ) {
-        assert( remaining_capacities[e] + aggregated_width[e] == graph.get_capacity(e) );
-        assert( remaining_capacities[e] >= 0 );
-    } 
-
-    return true;
 }
 
+// The reference kernel asks the graph for every direction and decodes the position of every neighbor. 
+
+template<bool respect_capacity, typename LayerPolicy>
+void Connector::expand_node_reference( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot ) const
+{
+    const int current_node = labels.node_of_slot( current_slot );
 
+    // the directions x_plus, x_minus, y_plus, y_minus come first 
+    constexpr int num_directions = LayerPolicy::has_vias ? 6 : 4;
 
+    const int z = current_node % problem.grid.layers;
 
+    for( int i = 0; i < num_directions; i++ ) 
+    {
+        const auto dir = static_cast<Graph::direction>( i );
 
+        if( not graph.is_direction_usable( z, dir ) or not graph.is_direction_possible( current_node, dir ) ) continue;
 
+        relax_edge<respect_capacity>( ws, context, labels, other, side, current_node, graph.get_edgeindex_from_node_and_direction( current_node, dir ) );
+    }
+}
 
 
 
+void Connector::relax_edge( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_node, int edgeindex, bool respect_capacity ) const
+{
+    if( respect_capacity ) 
+        relax_edge<true >( ws, context, labels, other, side, current_node, edgeindex );
+    else 
+        relax_edge<false>( ws, context, labels, other, side, current_node, edgeindex );
+}
 
+void Connector::expand_node( const SearchWorkspace& ws, SearchContext& context, SearchLabels& labels, const SearchLabels* other, int side, int current_slot, bool respect_capacity ) const
+{
+    if( options.reference_kernel ) {
+        if( problem.grid.layers == 1 ) {
+            if( respect_capacity ) expand_node_reference<true,  SingleLayer>( ws, context, labels, other, side, current_slot );
+            else                   expand_node_reference<false, SingleLayer>( ws, context, labels, other, side, current_slot );
+        } else {
+            if( respect_capacity ) expand_node_reference<true,  StackedLayers>( ws, context, labels, other, side, current_slot );
+            else                   expand_node_reference<false, StackedLayers>( ws, context, labels, other, side, current_slot );
+        }
+    } else if( problem.grid.layers == 1 ) {
+        if( respect_capacity ) expand_node<true,  SingleLayer>( ws, context, labels, other, side, current_slot );
+        else                   expand_node<false, SingleLayer>( ws, context, labels, other, side, current_slot );
+    } else {
+        if( respect_capacity ) expand_node<true,  StackedLayers>( ws, context, labels, other, side, current_slot );
+        else                   expand_node<false, StackedLayers>( ws, context, labels, other, side, current_slot );
+    }
+}
 
 
 
+// The width class of a net width 
 
+int Connector::width_class_of( int min_net_width ) const
+{
+    const auto it = std::lower_bound( width_classes.begin(), width_classes.end(), min_net_width );
+    assert( it != width_classes.end() and *it == min_net_width );
+    return it - width_classes.begin();
+}
 
 
 
+// Whether an edge can take another net of the width class. 
+// The bits are written under the commit mutex and may be read concurrently. 
 
-std::vector<std::set<int>> Connector::connect()
+bool Connector::is_admissible( int edgeindex, int width_class ) const
 {
-    std::vector<std::set<int>> trees( problem.nets.size() );
+    const auto& bits = admissible[width_class];
+    const std::uint64_t word = std::atomic_ref<std::uint64_t>( const_cast<std::uint64_t&>( bits[ edgeindex / 64 ] ) ).load( std::memory_order_relaxed );
+    return ( word >> ( edgeindex % 64 ) ) & 1;
+}
 
-    // For each net 
-    for( int n = 0; n < problem.nets.size(); n++ ) 
-    {
-        const auto& net = problem.nets[n];
-        
-        // list the tiles in the net 
-        const auto pins = net.pins;
 
-        // if there are no pins, then skip 
-        if( pins.size() == 0 ) continue;
 
-        std::clog << "Routing net\t " << n << "/" << problem.nets.size() << "\t pins: " << pins.size() << "\n";
+// Recompute the bits of an edge for all width classes after its aggregated width has changed 
 
-        std::vector<int> nodes;
-        nodes.reserve( pins.size() );
-        
-        for( const auto& pin : pins )
-        {
-            std::pair<int,int> tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+void Connector::update_admissible( int edgeindex )
+{
+    const auto direction = graph.get_edge_direction( edgeindex );
 
-            int nodeindex = graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer );
+    const auto nodes = graph.get_nodes_of_edge( edgeindex );
+    int x1, y1, z1;
+    std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( nodes.first );
 
-            nodes.push_back( nodeindex );
-        }
+    const std::uint64_t mask = std::uint64_t(1) << ( edgeindex % 64 );
 
-        {
-            std::sort(nodes.begin(), nodes.end());
-            auto last = std::unique(nodes.begin(), nodes.end());
-            nodes.erase(last, nodes.end());
-        }
+    for( int c = 0; c < width_classes.size(); c++ )
+    {
+        bool fits = graph.is_direction_usable( z1, direction );
 
-        // Bounding box 
-        BoundingBox BB = {
-            problem.grid.x_grids, 0,
-            problem.grid.y_grids, 0,
-            problem.grid.layers,  0,
-        };
+        if( direction != Graph::direction::z_plus ) 
+            fits = fits and load_aggregated_width( edgeindex ) + required_capacity_table[c][z1] <= graph.get_capacity( edgeindex );
 
-        for( auto nodeindex : nodes )
-        {
-            int x,y,z;
-            std::tie(x,y,z) = graph.get_position_from_nodeindex(nodeindex);
+        std::atomic_ref<std::uint64_t> word( admissible[c][ edgeindex / 64 ] );
 
-            BB.maxx = std::max( x, BB.maxx );
-            BB.minx = std::min( x, BB.minx );
-            
-            BB.maxy = std::max( y, BB.maxy );
-            BB.miny = std::min( y, BB.miny );
-            
-            BB.minz = std::min( z, BB.minz );
-            BB.maxz = std::max( z, BB.maxz );
-            
-            assert( not( BB.minx > x or BB.maxx < x or BB.miny > y or BB.maxy < y or BB.minz > z or BB.maxz < z ) );
-        }
+        if( fits ) 
+            word.fetch_or( mask, std::memory_order_relaxed );
+        else 
+            word.fetch_and( ~mask, std::memory_order_relaxed );
+    }
+}
 
-        BB.maxx = std::min(BB.maxx + 10, problem.grid.x_grids-1);
-        BB.maxy = std::min(BB.maxy + 10, problem.grid.y_grids-1);
-        BB.maxz = std::min(BB.maxz + 10, problem.grid.layers-1);
-        
-        BB.minx = std::max(BB.minx - 10, 0);
-        BB.miny = std::max(BB.miny - 10, 0);
-        BB.minz = std::max(BB.minz - 10, 0);
-        
-        assert( 0 <= BB.minx and BB.minx <= BB.maxx and BB.maxx < problem.grid.x_grids );
-        assert( 0 <= BB.miny and BB.miny <= BB.maxy and BB.maxy < problem.grid.y_grids );
-        assert( 0 <= BB.minz and BB.minz <= BB.maxz and BB.maxz < problem.grid.layers  );
-        
-        // having collected all nodes, separate them into S and T
 
-        std::set<int> S; 
-        std::set<int> T; 
 
-        // int random_index = rand() % nodes.size();
+// Offer a new distance to the node in `to_slot`, reached from `from_node` via `edgeindex`. 
 
-        int random_index = 0; // we assume that the pins are ordered to that the first one is at the center
+void Connector::update_label( SearchLabels& labels, int iteration, int from_node, int edgeindex, int to_slot, float new_distance ) const
+{
+    auto& label = labels[to_slot];
+    auto& pq    = labels.pq;
 
-        for( int i = 0; i < nodes.size(); i++ )
-        {
-            if( random_index == i )
-                S.insert( nodes[i] ); 
-            else 
-                T.insert( nodes[i] );
-        }
+    assert( label.queued <= iteration );
 
-        // std::clog << nodes.size() <<' '<< random_index <<' '<< S.size() <<' '<< T.size() << '\n';
-        assert( S.size() + T.size() == nodes.size() );
-        assert( S.size() == 1 );
-        
-        // create the Steiner tree 
+    if( label.queued < iteration ) {
 
-        int min_net_width = problem.nets[n].minimum_width;
+        // if the other node has not been queued yet, then insert 
 
-        const auto edgeindices = create_search_forest( S, T, min_net_width, BB, true );
+        assert( not pq.contains( to_slot ) );
 
-        trees[n] = edgeindices;
+        pq.push( to_slot, new_distance );
 
-        auto node_set = T; 
-        node_set.merge(S);
+        label.queued         = iteration;
+        
+        label.distance       = new_distance;
 
-        assert( verify_connector( n, node_set, edgeindices ) );
+        label.preceding_node = from_node;
 
-        // update the aggregated widths 
-        for( const auto edgeindex : edgeindices )
-        {
-            const auto edge_orientation = graph.get_edge_direction( edgeindex );
+        label.relevant_edge  = edgeindex;
 
-            if( edge_orientation == Graph::direction::z_plus ) continue;
+    } else if( label.queued == iteration && new_distance < label.distance ) {
 
-            auto nodes = graph.get_nodes_of_edge( edgeindex );
-            
-            int x1,y1,z1;
-            int x2,y2,z2;
-            std::tie( x1,y1,z1 ) = graph.get_position_from_nodeindex( nodes.first  );
-            std::tie( x2,y2,z2 ) = graph.get_position_from_nodeindex( nodes.second );
-            
-            assert( z1 == z2 );
-            assert( x1 == x2+1 or x1 == x2-1 or y1 == y2+1 or y1 == y2-1 );
-            if( x1 != x2 ) assert( y1 == y2 );
-            if( y1 != y2 ) assert( x1 == x2 );
-            
-            int required_capacity = std::max( min_net_width, problem.dimension.minimum_width[z1] ) + problem.dimension.minimum_spacing[z1];
-            
-            assert( required_capacity >= 0 );
-            
-            assert( aggregated_width[edgeindex] >= 0 );
-            
-            // assert( aggregated_width[edgeindex] + required_capacity <= graph.get_capacity(edgeindex) );
+        // if the other node has been queued already, then consider updating the weight 
 
-            aggregated_width[edgeindex] += required_capacity;
+        // if the other node has a distance larger than what is possible from `from_node`,
+        // then update or insert 
 
-            assert( aggregated_width[edgeindex] >= 0 );
-            
-            // assert( aggregated_width[edgeindex] <= graph.get_capacity( edgeindex ) );
-        }
+        // A settled node can only be improved after the search has been widened. 
+        // Then it is queued again. 
     
-    }
+        if( label.settled == iteration ) {
+            assert( not pq.contains( to_slot ) );
+            label.settled = -1;
+            pq.push( to_slot, new_distance );
+        } else {
+            assert( pq.contains( to_slot ) );
+            pq.setPriority( to_slot, new_distance );
+        }
+        
+        label.distance       = new_distance;
 
-    // assert( verify_capacities( trees, aggregated_width ) );
+        label.preceding_node = from_node;
 
-    return trees;
-}
+        label.relevant_edge  = edgeindex;
 
+    } else {
 
+        assert( label.queued == iteration );
+        assert( std::isfinite( label.distance ) );
+        assert( std::isfinite( new_distance ) );
+        assert( new_distance >= label.distance );
 
+    }
+}
 
 
 
-std::set<int> Connector::create_search_forest( 
-    const std::set<int>& S, const std::set<int>& T, 
+std::vector<int> Connector::create_search_forest( 
+    SearchWorkspace& ws,
+    const std::vector<int>& S, const std::vector<int>& T, 
     int min_net_width, 
-    BoundingBox BB,
+    const BoundingBox& pin_box, int margin,
     bool respect_capacity, 
     float capacity_penalty_factor )
 {
     assert( capacity_penalty_factor >= 0. and min_net_width >= 0 );
+
+    auto emergency_start_time = std::chrono::steady_clock::now();
+
+    // the search is restricted to this box in either mode 
+    BoundingBox BB = enlarge_box( pin_box, margin, problem.grid );
+
+    const int width_class = width_class_of( min_net_width );
+    
+    // the edges of the paths are collected here 
+    auto& ret = ws.edge_marks;
+    if( ret.bound() == 0 ) ret.resize( graph.count_edges() );
+    ret.clear();
+
+    // the search state of the calling thread 
+    auto& labels         = ws.forward;
+    auto& pq             = labels.pq;
+    auto& frontier       = labels.frontier;
     
-    // prepare this set to be returned 
-    std::set<int> ret; 
+    int& current_iteration = ws.current_iteration;
+
+    ws.emergency = not respect_capacity;
 
     // clear every possible leftover from the previous iteration 
-    pq.clear();
+    // NOTE: sources outside of the box need the labels of the whole graph 
+    const bool sources_inside_box = std::all_of( S.begin(), S.end(), [&]( int s ) {
+        int x, y, z;
+        std::tie(x,y,z) = graph.get_position_from_nodeindex( s );
+        return is_inside_box( BB, x, y, z );
+    });
+
+    labels.begin_search( BB, sources_inside_box ? options.local_search_nodes : 0 );
 
     // Increase iteration counter 
     current_iteration++;
     assert( current_iteration >= 0 );
 
-    std::clog << "BB: " << BB.maxx - BB.minx << tab << BB.maxy - BB.miny << tab << BB.maxz - BB.minz << nl;
-    std::clog << "PQ capacity (start): " << pq.capacity() << std::endl;
+    if constexpr( log_level >= log_level_search ) {
+        std::clog << "BB: " << BB.maxx - BB.minx << tab << BB.maxy - BB.miny << tab << BB.maxz - BB.minz << nl;
+        std::clog << "PQ capacity (start): " << pq.capacity() << nl;
+    }
     assert( pq.size() == 0 );
 
     // enter all source nodes into the queue
@@ -590,238 +2625,352 @@ std::set<int> Connector::create_search_forest(
     for( int s : S )
     {
         assert( 0 <= s && s < graph.count_nodes() );
-        pq.push( s, 0. );
-        queued[s]        = current_iteration;
-        preceding_node[s] = -1;
-        relevant_edge[s] = -1;
-        distance[s]       = 0.;
+        pq.push( labels.slot_of_node( s ), 0. );
+        auto& label = labels.at_node( s );
+        label.queued         = current_iteration;
+        label.preceding_node = -1;
+        label.relevant_edge  = -1;
+        label.distance       = 0.;
     }
 
-    auto active_T = T;
+    // the targets in increasing order, and whether they have been settled 
+    std::vector<int>  sorted_T( T.begin(), T.end() );
+    std::sort( sorted_T.begin(), sorted_T.end() );
+    std::vector<char> found_T( sorted_T.size(), false );
+    int               num_active_T = sorted_T.size();
 
     float last_distance = 0.; // TODO here a dummy variable to check that distances keep increasing 
     int max_pq_size = 0;
     int num_iterations = 0;
+    int num_emergency_iterations = 0;
 
-    if( respect_capacity )
-    for( auto nodeindex : active_T )
+    for( auto nodeindex : T )
     {
         int x, y, z;
         std::tie(x,y,z) = graph.get_position_from_nodeindex( nodeindex );
-        if( not( BB.minx > x or BB.maxx < x or BB.miny > y or BB.maxy < y or BB.minz > z or BB.maxz < z ) ) 
+        if( is_inside_box( BB, x, y, z ) ) 
         continue;
-        clog << "Terminal outside of box:\n";
-        std::clog << BB << nl;
-        std::clog << x << tab << y << tab << z << nl;
+        if constexpr( log_level >= log_level_search ) {
+            std::clog << "Terminal outside of box:\n";
+            std::clog << BB << nl;
+            std::clog << x << tab << y << tab << z << nl;
+        }
     }
+
+    // the state of the search that the relaxation needs besides the labels 
+    SearchContext context;
+    context.box                     = BB;
+    context.width_class             = width_class;
+    context.capacity_penalty_factor = capacity_penalty_factor;
+    context.iteration               = current_iteration;
                     
 
-    // keep searching as long as T is not empty, that is, not all targets have been found 
-    while( not active_T.empty() )
+    // keep searching as long as not all targets have been found 
+    while( num_active_T > 0 )
     {
         max_pq_size = std::max( max_pq_size, pq.size() );
 
         num_iterations++;
+        if( not respect_capacity ) num_emergency_iterations++;
         
         // if active_T still contains nodes but the PQ is empty,
         // then the graph is too congested to reach the remaining terminals.
-        // We enter unrestricted mode 
+        // First, we widen the search to a larger box. Only if that does not help either, 
+        // we relax the capacities within the largest box. 
+        // 
+        // The search continues from where it stopped: the distances found so far are lengths of actual paths, 
+        // since edges with enough capacity have the same weight in either mode. 
+        // The edges of the frontier are relaxed again under the new rules, 
+        // and settled nodes are queued again if they can be reached by a shorter path. 
         if( not respect_capacity ) assert( not pq.empty() );
 
         if( pq.empty() ){
             assert( respect_capacity );
-            std::clog << "EMERGENCY MODE" << nl;
-            return create_search_forest( S, T, min_net_width, BB, false, capacity_penalty_factor );
+            
+            if( margin < initial_box_margin * std::pow( box_growth_factor, max_box_expansions ) and not covers_grid( BB, problem.grid ) ) {
+                ws.box_expansions++;
+                margin *= box_growth_factor;
+                BB = enlarge_box( pin_box, margin, problem.grid );
+                context.box = BB;
+                labels.widen( BB, options.local_search_nodes, current_iteration );
+                if constexpr( log_level >= log_level_search ) std::clog << "Box expansion to margin " << margin << nl;
+            } else {
+                if constexpr( log_level >= log_level_search ) std::clog << "EMERGENCY MODE" << nl;
+                respect_capacity     = false;
+                ws.emergency         = true;
+                emergency_start_time = std::chrono::steady_clock::now();
+            }
+
+            const auto blocked_edges = std::move( frontier );
+            frontier.clear();
+
+            for( const auto& blocked : blocked_edges ) relax_edge( ws, context, labels, nullptr, 0, blocked.first, blocked.second, respect_capacity );
+
+            last_distance = 0.;
+
+            continue;
         }
 
         // get priority node and its distance 
         PriorityQueue<>::Entry current_entry = pq.pop();
 
-        int current_node     = current_entry.value;
+        int current_slot     = current_entry.value;
+        int current_node     = labels.node_of_slot( current_slot );
         
         float current_distance = current_entry.priority;
 
-        assert( std::isfinite( current_distance ) && std::isfinite( distance[current_node] ) );
-        assert( current_distance == distance[current_node] );
+        assert( std::isfinite( current_distance ) && std::isfinite( labels[current_slot].distance ) );
+        assert( current_distance == labels[current_slot].distance );
 
         // TODO: check that distance has increased 
         assert( last_distance <= current_distance ); last_distance = current_distance;
+
+        labels[current_slot].settled = current_iteration;
+        
+        ws.expansions++;
         
-        // get all edges at that node 
-        std::vector<int> edges = graph.get_edgeindices_from_node( current_node );
+        // relax all edges at that node 
+        expand_node( ws, context, labels, nullptr, 0, current_slot, respect_capacity );
 
-        // iterate over all edges 
-        for( const auto edgeindex : edges )
-        {
+        // we have processed all neighbors of the current node 
 
-            const auto current_edge = graph.get_nodes_of_edge( edgeindex );
+        const auto it = std::lower_bound( sorted_T.begin(), sorted_T.end(), current_node );
+        if( it != sorted_T.end() and *it == current_node and not found_T[ it - sorted_T.begin() ] ) {
+            found_T[ it - sorted_T.begin() ] = true;
+            num_active_T--;
+        }
 
-            const int other_node = ( current_edge.first == current_node ) ? current_edge.second : current_edge.first;
+    } // while target non empty 
 
-            if( other_node == current_edge.first  ) assert( current_edge.second == current_node );
-            if( other_node == current_edge.second ) assert( current_edge.first  == current_node );
+    // we have found all target nodes. Now collect all the edges 
 
+    for( const auto t : T )
+    {
+        
+        assert( labels.at_node( t ).queued == current_iteration );
 
-            if( respect_capacity )
-            {
-                int x, y, z;
-                std::tie(x,y,z) = graph.get_position_from_nodeindex( other_node );
-                if( BB.minx > x or BB.maxx < x or BB.miny > y or BB.maxy < y or BB.minz > z or BB.maxz < z ) {
-                    continue;
-                }
-            }
-            
-            const auto current_direction = graph.get_edge_direction( edgeindex );
+        int p = t;
+        
+        while( labels.at_node( p ).preceding_node != -1 ){
 
-            const int current_edge_capacity = graph.get_capacity( edgeindex );
+            assert( labels.at_node( p ).queued == current_iteration );
 
-            int required_capacity = 0;
+            int edgeindex = labels.at_node( p ).relevant_edge;
 
-            // if not in z direction, we need to check the capacity of the edge 
-            if( current_direction != Graph::direction::z_plus ) 
-            {
+            assert( edgeindex != -1 );
 
-                const auto nodes = graph.get_nodes_of_edge( edgeindex );
-                int x1, y1, z1, x2, y2, z2;
-                std::tie( x1, y1, z1 ) = graph.get_position_from_nodeindex( nodes.first  );
-                std::tie( x2, y2, z2 ) = graph.get_position_from_nodeindex( nodes.second );
+            const auto edge = graph.get_nodes_of_edge(edgeindex);
 
-                assert( z1 == z2 );
-                assert( x1 == x2+1 or x1 == x2-1 or y1 == y2+1 or y1 == y2-1 );
-                if( x1 != x2 ) assert( y1 == y2 );
-                if( y1 != y2 ) assert( x1 == x2 );
-                
-                const auto min_spacing = problem.dimension.minimum_spacing[z1];
-                const auto min_width   = problem.dimension.minimum_width[z1];
+            assert( edge.first == p or edge.second == p );
 
-                required_capacity = min_spacing + std::max(min_width,min_net_width);
-                
-                assert( std::isfinite( required_capacity             ) );
-                assert( std::isfinite( graph.get_capacity(edgeindex) ) );
+            // the paths form a forest: if the edge has been collected, then so has the rest of the path 
+            if( not ret.insert(edgeindex) ) break;
 
-                assert( std::isfinite( aggregated_width[edgeindex] ) );
-                assert( 0 <= aggregated_width[edgeindex] );
+            p = labels.at_node( p ).preceding_node;
 
-                // If there is no capacity, throw out the edge 
+            assert( edge.first == p or edge.second == p );
 
-                if( respect_capacity )
-                if( aggregated_width[edgeindex] + required_capacity > current_edge_capacity ) continue;
-            
-            }
+        }
 
-            // if( required_capacity + aggregated_width[edgeindex] > max_capacity ) std::clog << "Capacity ";
-            
-            if( respect_capacity ) {
-                assert( required_capacity + aggregated_width[edgeindex] <= current_edge_capacity );
-                assert( current_edge_capacity > 0 );
-            }
-            
-            // calculate the costs of the edge // NOTE each direction has unit cost 
-            int length_of_edge = 0;
-            if( current_direction == Graph::direction::x_plus ) length_of_edge += 1; // problem.tileInfo.tile_width;
-            if( current_direction == Graph::direction::y_plus ) length_of_edge += 1; // problem.tileInfo.tile_height;
-            if( current_direction == Graph::direction::z_plus ) length_of_edge += 1;
+        assert( labels.at_node( p ).preceding_node == -1 or ret.contains( labels.at_node( p ).relevant_edge ) );
+        assert( labels.at_node( p ).preceding_node != -1 or labels.at_node( p ).relevant_edge == -1 );
 
-            float edge_weight = length_of_edge; 
-            
-            if( not respect_capacity ) edge_weight += capacity_penalty_factor * std::max( 0.f, aggregated_width[edgeindex] - (float)current_edge_capacity );
-            
-            assert( std::isfinite( edge_weight ) );
+    }
+
+    if constexpr( log_level >= log_level_search ) {
+        std::clog << "PQ capacity (finish): " << pq.capacity() << "\t max use " << max_pq_size << "\t iterations " << num_iterations << "\n";
+    }
+
+    ws.net_counters.peak_queue = std::max( ws.net_counters.peak_queue, max_pq_size );
+    ws.net_counters.box_nodes  = std::max( ws.net_counters.box_nodes, count_box_nodes( BB ) );
+    ws.net_counters.emergency  = ws.net_counters.emergency or ws.emergency;
+
+    if( ws.emergency ) {
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - emergency_start_time ).count();
+        ws.emergency_searches++;
+        ws.emergency_expansions += num_emergency_iterations;
+        ws.emergency_seconds    += seconds;
+        if constexpr( log_level >= log_level_search ) std::clog << "EMERGENCY MODE expansions: " << num_emergency_iterations << "\t time: " << seconds << "s\n";
+    }
+    
+    std::vector<int> edgeindices = ret.get_members();
+    std::sort( edgeindices.begin(), edgeindices.end() );
 
-            float new_distance = distance[current_node] + edge_weight;
+    return edgeindices;
+}
 
-            assert( queued[other_node] <= current_iteration );
 
-            if( queued[other_node] < current_iteration ) {
 
-                // if the other node has not been queued yet, then insert 
+// Shortest path between two nodes, searched simultaneously from both ends. 
+// 
+// The side with the smaller queue is expanded next. Whenever an edge is relaxed towards a node 
+// that the other side has labeled, the joint path is a candidate for the shortest path, 
+// and `context.best_length` is the length of the best candidate. 
+// Once the smallest distances in the two queues add up to at least that length, 
+// no shorter path exists. This holds for any non-negative edge weights, 
+// hence also for the penalties of the emergency mode. 
+// 
+// Widening the search works as in `create_search_forest`, for both sides. 
 
-                assert( not pq.contains( other_node ) );
+std::vector<int> Connector::create_bidirectional_path( 
+    SearchWorkspace& ws,
+    int s, int t, 
+    int min_net_width, 
+    const BoundingBox& pin_box, int margin,
+    bool respect_capacity, 
+    float capacity_penalty_factor )
+{
+    assert( capacity_penalty_factor >= 0. and min_net_width >= 0 );
+    assert( s != t );
 
-                pq.push( other_node, new_distance );
+    auto emergency_start_time = std::chrono::steady_clock::now();
 
-                queued[other_node]         = current_iteration;
-                
-                distance[other_node]       = new_distance;
+    // the search is restricted to this box in either mode 
+    BoundingBox BB = enlarge_box( pin_box, margin, problem.grid );
 
-                preceding_node[other_node] = current_node;
+    const int width_class = width_class_of( min_net_width );
 
-                relevant_edge[other_node]  = edgeindex;
+    if( not ws.backward.is_allocated() ) ws.backward.allocate( layout );
 
-            } else if( queued[other_node] == current_iteration && new_distance < distance[other_node] ) {
+    SearchLabels* sides[2] = { &ws.forward, &ws.backward };
 
-                // if the other node has been queued already, then consider updating the weight 
+    int& current_iteration = ws.current_iteration;
 
-                // if the other node has a distance larger than what is possible from `current_node`,
-                // then update or insert 
-            
-                assert( pq.contains( other_node ) );
+    ws.emergency = not respect_capacity;
 
-                pq.setPriority( other_node, new_distance );
-                
-                distance[other_node]       = new_distance;
+    current_iteration++;
+    assert( current_iteration >= 0 );
 
-                preceding_node[other_node] = current_node;
+    const int sources[2] = { s, t };
 
-                relevant_edge[other_node]  = edgeindex;
+    for( int d = 0; d < 2; d++ )
+    {
+        auto& labels = *sides[d];
+        labels.begin_search( BB, options.local_search_nodes );
+
+        const int source = sources[d];
+        labels.pq.push( labels.slot_of_node( source ), 0. );
+        auto& label = labels.at_node( source );
+        label.queued         = current_iteration;
+        label.preceding_node = -1;
+        label.relevant_edge  = -1;
+        label.distance       = 0.;
+    }
 
-            } else {
+    int num_iterations = 0;
+    int num_emergency_iterations = 0;
+    int max_pq_size = 0;
 
-                // std::clog << queued[other_node] <<' '<< current_iteration <<' '<< new_distance <<' '<< distance[other_node] <<'\n';
-                // std::clog << distance[current_node] <<' '<< edge_weight <<'\n';
-                assert( queued[other_node] == current_iteration );
-                assert( std::isfinite( distance[other_node] ) );
-                assert( std::isfinite( new_distance ) );
-                assert( new_distance >= distance[other_node] );
+    // the state of the search that the relaxation needs besides the labels 
+    SearchContext context;
+    context.box                     = BB;
+    context.use_corridor            = respect_capacity and not ws.corridor.empty(); // the corridor of the coarse route, if there is one 
+    context.width_class             = width_class;
+    context.capacity_penalty_factor = capacity_penalty_factor;
+    context.iteration               = current_iteration;
 
+    while( true )
+    {
+        num_iterations++;
+        if( not respect_capacity ) num_emergency_iterations++;
+
+        // If one side has run out of nodes, then it has explored everything that it can reach. 
+        // If no path has been found by then, we widen the search. 
+        if( ws.forward.pq.empty() or ws.backward.pq.empty() )
+        {
+            if( context.best_edge != -1 ) break;
+
+            assert( respect_capacity );
+
+            if( context.use_corridor ) {
+                ws.corridor_failures++;
+                context.use_corridor = false;
+            } else if( margin < initial_box_margin * std::pow( box_growth_factor, max_box_expansions ) and not covers_grid( BB, problem.grid ) ) {
+                ws.box_expansions++;
+                margin *= box_growth_factor;
+                BB = enlarge_box( pin_box, margin, problem.grid );
+                context.box = BB;
+                for( int d = 0; d < 2; d++ ) sides[d]->widen( BB, options.local_search_nodes, current_iteration );
+                if constexpr( log_level >= log_level_search ) std::clog << "Box expansion to margin " << margin << nl;
+            } else {
+                if constexpr( log_level >= log_level_search ) std::clog << "EMERGENCY MODE" << nl;
+                respect_capacity     = false;
+                ws.emergency         = true;
+                emergency_start_time = std::chrono::steady_clock::now();
+                // the corridor stays off: the coarse route ignores the box, so the corridor within the box may be disconnected, 
+                // whereas the whole box always contains a path once the capacities are relaxed 
             }
 
-            
+            for( int d = 0; d < 2; d++ )
+            {
+                const auto blocked_edges = std::move( sides[d]->frontier );
+                sides[d]->frontier.clear();
+                for( const auto& blocked : blocked_edges ) relax_edge( ws, context, *sides[d], sides[1-d], d, blocked.first, blocked.second, respect_capacity );
+            }
 
-        } // iteration over edges 
+            continue;
+        }
 
-        // we have processed all neighbors of the current node 
+        // stopping rule 
+        if( ws.forward.pq.peek().priority + ws.backward.pq.peek().priority >= context.best_length ) break;
 
-        if( active_T.contains(current_node) ) active_T.erase( current_node );
+        const int d = ( ws.forward.pq.size() <= ws.backward.pq.size() ) ? 0 : 1;
 
-    } // while target non empty 
+        max_pq_size = std::max( max_pq_size, ws.forward.pq.size() + ws.backward.pq.size() );
 
-    // we have found all target nodes. Now collect all the edges 
+        auto& labels = *sides[d];
 
-    for( const auto t : T )
-    {
-        
-        assert( queued[t] == current_iteration );
+        const int current_slot = labels.pq.pop().value;
 
-        int p = t;
-        
-        while( preceding_node[p] != -1 ){
+        labels[current_slot].settled = current_iteration;
 
-            assert( queued[p] == current_iteration );
+        ws.expansions++;
 
-            int edgeindex = relevant_edge[p];
+        expand_node( ws, context, labels, sides[1-d], d, current_slot, respect_capacity );
+    }
 
-            assert( edgeindex != -1 );
+    assert( context.best_edge != -1 and std::isfinite( context.best_length ) );
 
-            const auto edge = graph.get_nodes_of_edge(edgeindex);
+    // join the paths of the two sides at the best edge 
 
-            assert( edge.first == p or edge.second == p );
+    std::vector<int> ret;
 
-            ret.insert(edgeindex);
+    ret.push_back( context.best_edge );
 
-            p = preceding_node[p];
+    for( int d = 0; d < 2; d++ )
+    {
+        const auto& labels = *sides[d];
 
-            assert( edge.first == p or edge.second == p );
+        int p = context.best_node[d];
 
+        while( labels.at_node( p ).preceding_node != -1 )
+        {
+            assert( labels.at_node( p ).queued == current_iteration );
+            ret.push_back( labels.at_node( p ).relevant_edge );
+            p = labels.at_node( p ).preceding_node;
         }
 
-        assert( preceding_node[p] == -1 );
-        assert( relevant_edge[p]  == -1 );
+        assert( p == sources[d] );
+    }
+
+    // the two halves of a shortest path do not share edges 
+    std::sort( ret.begin(), ret.end() );
+    assert( std::adjacent_find( ret.begin(), ret.end() ) == ret.end() );
+
+    if constexpr( log_level >= log_level_search ) std::clog << "Bidirectional search iterations " << num_iterations << "\n";
 
+    ws.net_counters.peak_queue = std::max( ws.net_counters.peak_queue, max_pq_size );
+    ws.net_counters.box_nodes  = std::max( ws.net_counters.box_nodes, count_box_nodes( BB ) );
+    ws.net_counters.emergency  = ws.net_counters.emergency or ws.emergency;
+
+    if( ws.emergency ) {
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - emergency_start_time ).count();
+        ws.emergency_searches++;
+        ws.emergency_expansions += num_emergency_iterations;
+        ws.emergency_seconds    += seconds;
+        if constexpr( log_level >= log_level_search ) std::clog << "EMERGENCY MODE expansions: " << num_emergency_iterations << "\t time: " << seconds << "s\n";
     }
 
-    std::clog << "PQ capacity (finish): " << pq.capacity() << "\t max use " << max_pq_size << "\t iterations " << num_iterations << "\n";
-    
     return ret;
 }
 
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "common.hpp"
+#include "evaluator.hpp"
+#include "graph.hpp"
+#include "grp.hpp"
+#include "grp2graph.hpp"
+#include "solution_store.hpp"
+
+// Scores an existing solution file of an instance, without routing, under the conventions of evaluator.hpp. 
+// These estimate the scores of the contest script eval2008.pl but have not been checked against it. 
+
+int main( int argc, char* argv[] )
+{
+    std::string instancefilename;
+    std::string solutionfilename;
+
+    int via_cost = Evaluator::default_via_cost;
+
+    for( int i = 1; i < argc; i++ ) {
+        const std::string argument = argv[i];
+
+        if( argument == "--via-cost" and i + 1 < argc ) {
+            via_cost = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument.starts_with( "--" ) ) {
+            std::cerr << "Unknown option: " << argument << "\n";
+            return 1;
+        } else if( instancefilename.empty() ) {
+            instancefilename = argument;
+        } else {
+            solutionfilename = argument;
+        }
+    }
+
+    if( instancefilename.empty() or solutionfilename.empty() ) {
+        std::cerr << "Usage: " << argv[0] << " instance.gr instance.gr.solution [--via-cost N]\n";
+        return 1;
+    }
+
+    std::ifstream file( instancefilename );
+
+    if( !file ) {
+        std::cerr << "Unable to open file: " << instancefilename << "\n";
+        return 1;
+    }
+
+    GlobalRoutingProblem problem;
+    problem.read( file );
+    file.close();
+
+    if( !problem.check() ) {
+        std::cerr << "Data verification failed.\n";
+        return 1;
+    }
+
+    const Graph graph = createGraphFromGlobalRoutingProblem( problem );
+
+    const Evaluator evaluator( problem, graph, via_cost );
+
+    SolutionStore trees;
+
+    if( not evaluator.read_solution( solutionfilename, trees ) ) return 1;
+
+    std::cout << evaluator.evaluate( trees ) << "\n";
+
+    std::clog << "Estimate under the conventions of the router, the contest scores are given by eval2008.pl\n";
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef IG_EVALUATOR
+#define IG_EVALUATOR
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "graph.hpp"
+#include "grp.hpp"
+#include "solution_store.hpp"
+
+// Scores of a solution in the terms of the contest: 
+// the overflow in tracks, summed over all edges and on the worst edge, 
+// and the wirelength, where each via counts as `via_cost` units of length. 
+
+struct Evaluation
+{
+    long total_overflow   = 0;
+    int  max_overflow     = 0;
+    int  overflowed_edges = 0;
+
+    // planar edges and vias of all nets 
+    long wirelength = 0;
+    long vias       = 0;
+
+    int via_cost = 1;
+
+    long total_wirelength() const { return wirelength + via_cost * vias; }
+};
+
+std::ostream& operator<<( std::ostream& os, const Evaluation& evaluation )
+{
+    return os << "Total overflow: "   << evaluation.total_overflow 
+              << "\t max overflow: "  << evaluation.max_overflow 
+              << "\t overflowed edges: " << evaluation.overflowed_edges 
+              << "\t wirelength: "    << evaluation.total_wirelength() 
+              << " (" << evaluation.wirelength << " wires, " << evaluation.vias << " vias of cost " << evaluation.via_cost << ")";
+}
+
+
+
+// Evaluation of solutions, either from the usage that the router maintains, 
+// or from the trees alone, such as those read from a solution file. 
+// 
+// A net uses the capacity max( net width, layer width ) + layer spacing on each planar edge of its tree, 
+// as in the router. The overflow of an edge is converted into tracks of minimum width and spacing of its layer, rounding up. 
+// If every net on an edge uses one track, as in the benchmark set, this equals the usage in tracks minus the whole tracks 
+// of the capacity, since ceil( ( u * t - c ) / t ) = u - floor( c / t ). 
+// NOTE: these are the conventions of the router, which have not been checked against the contest script eval2008.pl. 
+// The scores estimate the contest scores and compare solutions with each other; compare_evaluation.sh checks both on an instance. 
+
+class Evaluator
+{
+  public:
+
+    explicit Evaluator( const GlobalRoutingProblem& problem, const Graph& graph, int via_cost = default_via_cost );
+
+    // the usage of every edge by the trees 
+    std::vector<int> compute_usage( const SolutionStore& trees ) const;
+
+    Evaluation evaluate( std::span<const int> usage, const SolutionStore& trees ) const;
+
+    Evaluation evaluate( const SolutionStore& trees ) const;
+
+    // Read the trees of a solution file, in the order of the nets of the problem. 
+    // Segments across several tiles are split into edges, and repeated edges of a net count once. 
+    // Returns false and reports the first error if the file cannot be read. 
+    bool read_solution( const std::string& filename, SolutionStore& trees ) const;
+
+    static const int default_via_cost;
+
+  private:
+
+    const GlobalRoutingProblem& problem;
+    const Graph&                graph;
+    const Graph::Layout         layout;
+    const int                   via_cost;
+};
+
+const int Evaluator::default_via_cost = 1;
+
+Evaluator::Evaluator( const GlobalRoutingProblem& problem, const Graph& graph, int via_cost )
+: problem( problem ), graph( graph ), layout( graph.get_layout() ), via_cost( via_cost )
+{
+    assert( layout.dim_x == problem.grid.x_grids and layout.dim_y == problem.grid.y_grids and layout.dim_z == problem.grid.layers );
+    assert( via_cost >= 0 );
+}
+
+std::vector<int> Evaluator::compute_usage( const SolutionStore& trees ) const
+{
+    assert( trees.count_nets() == problem.nets.size() );
+
+    std::vector<int> usage( graph.count_edges(), 0 );
+
+    for( int n = 0; n < trees.count_nets(); n++ )
+    {
+        const int min_net_width = problem.nets[n].minimum_width;
+
+        for( const int e : trees.edges_of( n ) )
+        {
+            if( e >= layout.z_edges_offset ) continue;
+
+            // the layer is the remainder of the edge index in both planar blocks 
+            const int z = e % layout.dim_z;
+
+            usage[e] += std::max( min_net_width, problem.dimension.minimum_width[z] ) + problem.dimension.minimum_spacing[z];
+        }
+    }
+
+    return usage;
+}
+
+Evaluation Evaluator::evaluate( std::span<const int> usage, const SolutionStore& trees ) const
+{
+    assert( usage.size() == graph.count_edges() );
+
+    Evaluation ret;
+    ret.via_cost = via_cost;
+
+    for( int e = 0; e < layout.z_edges_offset; e++ )
+    {
+        const int excess = usage[e] - graph.get_capacity( e );
+
+        if( excess <= 0 ) continue;
+
+        const int z     = e % layout.dim_z;
+        const int track = std::max( 1, problem.dimension.minimum_width[z] + problem.dimension.minimum_spacing[z] );
+
+        const int overflow = ( excess + track - 1 ) / track;
+
+        ret.total_overflow += overflow;
+        ret.max_overflow    = std::max( ret.max_overflow, overflow );
+        ret.overflowed_edges++;
+    }
+
+    for( int n = 0; n < trees.count_nets(); n++ )
+    {
+        const auto tree = trees.edges_of( n );
+        const long planar = std::lower_bound( tree.begin(), tree.end(), layout.z_edges_offset ) - tree.begin();
+        assert( std::is_sorted( tree.begin(), tree.end() ) );
+        ret.wirelength += planar;
+        ret.vias       += tree.size() - planar;
+    }
+
+    return ret;
+}
+
+Evaluation Evaluator::evaluate( const SolutionStore& trees ) const
+{
+    const auto usage = compute_usage( trees );
+    return evaluate( usage, trees );
+}
+
+bool Evaluator::read_solution( const std::string& filename, SolutionStore& trees ) const
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::ifstream file( filename, std::ios::binary );
+
+    if( not file ) {
+        std::cerr << "Unable to open file: " << filename << nl;
+        return false;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    const std::string text = contents.str();
+
+    std::unordered_map<int,int> net_of_id;
+    for( int n = 0; n < problem.nets.size(); n++ ) net_of_id[ problem.nets[n].id ] = n;
+
+    trees = SolutionStore( problem.nets.size() );
+
+    const char* position = text.data();
+    const char* const end = text.data() + text.size();
+    int line = 1;
+
+    const auto fail = [&]( const std::string& message ) -> bool {
+        std::cerr << filename << ":" << line << ": " << message << nl;
+        return false;
+    };
+
+    const auto skip_spaces = [&]() -> void {
+        while( position < end and ( *position == ' ' or *position == '\t' or *position == '\r' or *position == '\n' ) ) {
+            if( *position == '\n' ) line++;
+            position++;
+        }
+    };
+
+    const auto read_word = [&]() -> std::string_view {
+        skip_spaces();
+        const char* start = position;
+        while( position < end and *position != ' ' and *position != '\t' and *position != '\r' and *position != '\n' ) position++;
+        return std::string_view( start, position - start );
+    };
+
+    const auto read_int = [&]( int& value ) -> bool {
+        skip_spaces();
+        const auto result = std::from_chars( position, end, value );
+        if( result.ec != std::errc() ) return false;
+        position = result.ptr;
+        return true;
+    };
+
+    const auto expect = [&]( char c ) -> bool {
+        skip_spaces();
+        if( position == end or *position != c ) return false;
+        position++;
+        return true;
+    };
+
+    // a point (x,y,z) in physical coordinates and one-based layers, converted to tiles 
+    const auto read_point = [&]( int& tx, int& ty, int& tz ) -> bool {
+        int x, y, z;
+        if( not ( expect( '(' ) and read_int( x ) and expect( ',' ) and read_int( y ) and expect( ',' ) and read_int( z ) and expect( ')' ) ) ) return false;
+        tx = x - problem.tileInfo.lower_left_x;
+        ty = y - problem.tileInfo.lower_left_y;
+        if( tx < 0 or ty < 0 ) return false;
+        tx /= problem.tileInfo.tile_width;
+        ty /= problem.tileInfo.tile_height;
+        tz = z - 1;
+        return tx < layout.dim_x and ty < layout.dim_y and 0 <= tz and tz < layout.dim_z;
+    };
+
+    std::vector<char> seen( problem.nets.size(), false );
+    std::vector<int>  net_edges;
+
+    while( true )
+    {
+        const std::string_view name = read_word();
+        if( name.empty() ) break;
+
+        int id, num_segments;
+        if( not read_int( id ) or not read_int( num_segments ) or num_segments < 0 ) return fail( "expected the id and the number of segments of a net" );
+
+        const auto found = net_of_id.find( id );
+        if( found == net_of_id.end() or problem.nets[ found->second ].name != name ) return fail( "unknown net " + std::string( name ) );
+
+        const int n = found->second;
+        if( seen[n] ) return fail( "repeated net " + std::string( name ) );
+        seen[n] = true;
+
+        net_edges.clear();
+
+        for( int s = 0; s < num_segments; s++ )
+        {
+            int x1, y1, z1, x2, y2, z2;
+            if( not ( read_point( x1, y1, z1 ) and expect( '-' ) and read_point( x2, y2, z2 ) ) ) return fail( "invalid segment" );
+
+            if( ( x1 != x2 ) + ( y1 != y2 ) + ( z1 != z2 ) > 1 ) return fail( "segment is not parallel to an axis" );
+
+            if( x1 > x2 ) std::swap( x1, x2 );
+            if( y1 > y2 ) std::swap( y1, y2 );
+            if( z1 > z2 ) std::swap( z1, z2 );
+
+            for( int x = x1; x < x2; x++ ) net_edges.push_back( layout.x_edge( x, y1, z1 ) );
+            for( int y = y1; y < y2; y++ ) net_edges.push_back( layout.y_edge( x1, y, z1 ) );
+            for( int z = z1; z < z2; z++ ) net_edges.push_back( layout.z_edge( x1, y1, z ) );
+        }
+
+        if( not expect( '!' ) ) return fail( "expected ! after the segments of net " + std::string( name ) );
+
+        std::sort( net_edges.begin(), net_edges.end() );
+        net_edges.erase( std::unique( net_edges.begin(), net_edges.end() ), net_edges.end() );
+
+        trees.assign( n, net_edges );
+    }
+
+    const int missing = std::count( seen.begin(), seen.end(), false );
+    if( missing > 0 ) std::clog << "Nets without a record in the solution: " << missing << nl;
+
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+    std::clog << "Read " << trees.count_edges() << " edges of " << problem.nets.size() - missing << " nets in " << seconds << "s" << nl;
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "common.hpp"
+#include "generator.hpp"
+#include "grp.hpp"
+
+// Writes a synthetic instance, see generator.hpp 
+
+int main( int argc, char* argv[] )
+{
+    GeneratorParameters parameters;
+
+    std::string outputfilename;
+
+    for( int i = 1; i < argc; i++ ) {
+        const std::string argument = argv[i];
+
+        if( argument == "--seed" and i + 1 < argc ) {
+            parameters.seed = std::strtoul( argv[++i], nullptr, 10 );
+        } else if( argument == "--grid" and i + 2 < argc ) {
+            parameters.x_grids = std::max( 1, std::atoi( argv[++i] ) );
+            parameters.y_grids = std::max( 1, std::atoi( argv[++i] ) );
+        } else if( argument == "--layers" and i + 1 < argc ) {
+            parameters.layers = std::max( 1, std::atoi( argv[++i] ) );
+        } else if( argument == "--tracks" and i + 1 < argc ) {
+            parameters.tracks = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument == "--nets" and i + 1 < argc ) {
+            parameters.num_nets = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument == "--max-pins" and i + 1 < argc ) {
+            parameters.max_pins = std::max( 2, std::atoi( argv[++i] ) );
+        } else if( argument == "--pin-exponent" and i + 1 < argc ) {
+            parameters.pin_exponent = std::atof( argv[++i] );
+        } else if( argument == "--net-radius" and i + 1 < argc ) {
+            parameters.net_radius = std::max( 0., std::atof( argv[++i] ) );
+        } else if( argument == "--clusters" and i + 1 < argc ) {
+            parameters.clusters = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument == "--cluster-spread" and i + 1 < argc ) {
+            parameters.cluster_spread = std::max( 0., std::atof( argv[++i] ) );
+        } else if( argument == "--wide-nets" and i + 1 < argc ) {
+            parameters.wide_net_fraction = std::clamp( std::atof( argv[++i] ), 0., 1. );
+        } else if( argument == "--adjustments" and i + 1 < argc ) {
+            parameters.adjustment_density = std::clamp( std::atof( argv[++i] ), 0., 1. );
+        } else if( argument == "-o" and i + 1 < argc ) {
+            outputfilename = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << argument << "\n";
+            std::cerr << "Usage: " << argv[0] << " [--seed S] [--grid X Y] [--layers L] [--tracks T] [--nets N] [--max-pins K] [--pin-exponent A]"
+                      << " [--net-radius R] [--clusters C] [--cluster-spread S] [--wide-nets F] [--adjustments D] [-o instance.gr]\n";
+            return 1;
+        }
+    }
+
+    const GlobalRoutingProblem problem = ProblemGenerator( parameters ).generate();
+
+    assert( problem.check() );
+
+    long num_pins = 0;
+    for( const auto& net : problem.nets ) num_pins += net.num_pins;
+
+    std::clog << "Generated " << problem.nets.size() << " nets with " << num_pins << " pins on a " 
+              << problem.grid.x_grids << "x" << problem.grid.y_grids << "x" << problem.grid.layers << " grid"
+              << " with " << problem.capacityAdjustments.size() << " capacity adjustments\n";
+
+    if( outputfilename.empty() ) {
+        problem.write( std::cout );
+        return std::cout.good() ? 0 : 1;
+    }
+
+    std::ofstream file( outputfilename );
+    problem.write( file );
+
+    if( not file.good() ) {
+        std::cerr << "Unable to write output file\n";
+        return 1;
+    }
+
+    std::clog << "Wrote file: " << outputfilename << "\n";
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef IG_GENERATOR
+#define IG_GENERATOR
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "grp.hpp"
+
+// Synthetic instances of the global routing problem for benchmarks. 
+// 
+// Every layer has capacity in one direction only, horizontal on the first layer and alternating above, 
+// unless there is a single layer, which has capacity in both directions. All pins are on the first layer. 
+// 
+// The number of pins of each net follows a power law, P(k) ~ (k-1)^(-pin_exponent) for 2 <= k <= max_pins, 
+// which mimics the dominance of two-pin nets in real designs. The pins are spread around a center, 
+// within a box whose extent grows with the number of pins and an exponentially distributed radius. 
+// The centers are uniform over the grid, or, with clusters, normally distributed around a few cluster centers. 
+// Each planar edge receives a reduced capacity with probability adjustment_density. 
+// 
+// The instance only depends on the parameters: the random numbers are derived from the raw output 
+// of std::mt19937_64, whose sequence is fixed by the standard, and not from the distributions of the 
+// standard library, which differ between implementations. 
+
+struct GeneratorParameters
+{
+    unsigned long seed = 1;
+
+    int x_grids = 64;
+    int y_grids = 64;
+    int layers  = 2;
+
+    int tracks    = 10;     // tracks per tile in the routing direction of each layer 
+    int tile_size = 10;
+
+    int    num_nets     = 1000;
+    int    max_pins     = 16;
+    double pin_exponent = 2.;
+    double net_radius   = 3.;       // mean radius of the nets in tiles, beyond the minimum for their pins 
+
+    int    clusters       = 0;      // zero for uniform net centers 
+    double cluster_spread = 8.;     // standard deviation of the net centers around a cluster center, in tiles 
+
+    double wide_net_fraction  = 0.;     // share of nets with twice the minimum width 
+    double adjustment_density = 0.;     // share of planar edges with reduced capacity 
+};
+
+class ProblemGenerator
+{
+  public:
+
+    explicit ProblemGenerator( const GeneratorParameters& parameters );
+
+    GlobalRoutingProblem generate();
+
+  private:
+
+    GeneratorParameters parameters;
+
+    std::mt19937_64 engine;
+
+    // integer in [0,n) 
+    int uniform_below( int n );
+
+    // real number in [0,1) 
+    double uniform_real();
+
+    double exponential( double mean );
+
+    double normal( double mean, double deviation );
+
+    int draw_pin_count( const std::vector<double>& cumulative_weights );
+
+    Net draw_net( int id, int center_x, int center_y, const std::vector<double>& cumulative_weights );
+};
+
+ProblemGenerator::ProblemGenerator( const GeneratorParameters& parameters )
+: parameters( parameters ), engine( parameters.seed )
+{
+    assert( parameters.x_grids > 0 and parameters.y_grids > 0 and parameters.layers > 0 );
+    assert( parameters.tracks >= 0 and parameters.tile_size > 0 );
+    assert( parameters.num_nets >= 0 and parameters.max_pins >= 2 );
+    assert( parameters.net_radius >= 0. and parameters.cluster_spread >= 0. );
+    assert( 0. <= parameters.adjustment_density and parameters.adjustment_density <= 1. );
+}
+
+int ProblemGenerator::uniform_below( int n )
+{
+    assert( n > 0 );
+    // the bias of the modulo is below n / 2^64 
+    return static_cast<int>( engine() % static_cast<unsigned>( n ) );
+}
+
+double ProblemGenerator::uniform_real()
+{
+    return ( engine() >> 11 ) * 0x1.0p-53;
+}
+
+double ProblemGenerator::exponential( double mean )
+{
+    return -mean * std::log( 1. - uniform_real() );
+}
+
+double ProblemGenerator::normal( double mean, double deviation )
+{
+    // Box-Muller transform 
+    const double u = 1. - uniform_real();
+    const double v = uniform_real();
+    return mean + deviation * std::sqrt( -2. * std::log( u ) ) * std::cos( 2. * std::numbers::pi * v );
+}
+
+int ProblemGenerator::draw_pin_count( const std::vector<double>& cumulative_weights )
+{
+    const double r = uniform_real() * cumulative_weights.back();
+    const int    k = std::upper_bound( cumulative_weights.begin(), cumulative_weights.end(), r ) - cumulative_weights.begin();
+    return 2 + std::min<int>( k, cumulative_weights.size() - 1 );
+}
+
+Net ProblemGenerator::draw_net( int id, int center_x, int center_y, const std::vector<double>& cumulative_weights )
+{
+    Net net;
+    net.name          = "net" + std::to_string( id );
+    net.id            = id;
+    net.num_pins      = draw_pin_count( cumulative_weights );
+    net.minimum_width = ( uniform_real() < parameters.wide_net_fraction ) ? 2 : 1;
+
+    // half the side of the box of the pins, in tiles 
+    const int radius = std::ceil( std::sqrt( net.num_pins ) / 2. + exponential( parameters.net_radius ) );
+
+    const int x_min = std::max( 0, center_x - radius ), x_max = std::min( parameters.x_grids - 1, center_x + radius );
+    const int y_min = std::max( 0, center_y - radius ), y_max = std::min( parameters.y_grids - 1, center_y + radius );
+
+    // pins on distinct tiles where the box allows it 
+    std::vector<std::pair<int,int>> tiles;
+
+    for( int p = 0; p < net.num_pins; p++ ) {
+
+        int tx = x_min, ty = y_min;
+        for( int attempt = 0; attempt < 8; attempt++ ) {
+            tx = x_min + uniform_below( x_max - x_min + 1 );
+            ty = y_min + uniform_below( y_max - y_min + 1 );
+            if( std::find( tiles.begin(), tiles.end(), std::make_pair( tx, ty ) ) == tiles.end() ) break;
+        }
+        tiles.emplace_back( tx, ty );
+
+        Pin pin;
+        pin.x     = tx * parameters.tile_size + uniform_below( parameters.tile_size );
+        pin.y     = ty * parameters.tile_size + uniform_below( parameters.tile_size );
+        pin.layer = 0;
+        net.pins.push_back( pin );
+    }
+
+    return net;
+}
+
+GlobalRoutingProblem ProblemGenerator::generate()
+{
+    engine.seed( parameters.seed );
+
+    const int L = parameters.layers;
+
+    GlobalRoutingProblem problem;
+
+    problem.grid.x_grids = parameters.x_grids;
+    problem.grid.y_grids = parameters.y_grids;
+    problem.grid.layers  = L;
+
+    // the capacity is given in units of length, one track takes the minimum width and spacing 
+    const int track = 2;
+
+    for( int z = 0; z < L; z++ ) {
+        const bool horizontal = ( L == 1 or z % 2 == 0 );
+        const bool vertical   = ( L == 1 or z % 2 == 1 );
+        problem.capacity.horizontal.push_back( horizontal ? parameters.tracks * track : 0 );
+        problem.capacity.vertical.push_back(   vertical   ? parameters.tracks * track : 0 );
+        problem.dimension.minimum_width.push_back( 1 );
+        problem.dimension.minimum_spacing.push_back( 1 );
+        problem.dimension.via_spacing.push_back( 1 );
+    }
+
+    problem.tileInfo.lower_left_x = 0;
+    problem.tileInfo.lower_left_y = 0;
+    problem.tileInfo.tile_width   = parameters.tile_size;
+    problem.tileInfo.tile_height  = parameters.tile_size;
+
+    // Nets 
+
+    std::vector<double> cumulative_weights;
+    for( int k = 2; k <= parameters.max_pins; k++ ) {
+        const double weight = std::pow( k - 1., -parameters.pin_exponent );
+        cumulative_weights.push_back( weight + ( cumulative_weights.empty() ? 0. : cumulative_weights.back() ) );
+    }
+
+    std::vector<std::pair<int,int>> cluster_centers;
+    for( int c = 0; c < parameters.clusters; c++ ) {
+        cluster_centers.emplace_back( uniform_below( parameters.x_grids ), uniform_below( parameters.y_grids ) );
+    }
+
+    problem.nets.reserve( parameters.num_nets );
+
+    for( int n = 0; n < parameters.num_nets; n++ ) {
+
+        int center_x, center_y;
+
+        if( cluster_centers.empty() ) {
+            center_x = uniform_below( parameters.x_grids );
+            center_y = uniform_below( parameters.y_grids );
+        } else {
+            const auto [ cx, cy ] = cluster_centers[ uniform_below( cluster_centers.size() ) ];
+            center_x = std::clamp<int>( std::lround( normal( cx, parameters.cluster_spread ) ), 0, parameters.x_grids - 1 );
+            center_y = std::clamp<int>( std::lround( normal( cy, parameters.cluster_spread ) ), 0, parameters.y_grids - 1 );
+        }
+
+        problem.nets.push_back( draw_net( n, center_x, center_y, cumulative_weights ) );
+    }
+
+    // Capacity adjustments, along the routing direction of each layer 
+
+    if( parameters.adjustment_density > 0. ) {
+        for( int z = 0; z < L; z++ ) {
+            for( int x = 0; x < parameters.x_grids; x++ ) {
+                for( int y = 0; y < parameters.y_grids; y++ ) {
+
+                    if( problem.capacity.horizontal[z] > 0 and x + 1 < parameters.x_grids and uniform_real() < parameters.adjustment_density ) {
+                        const int adjusted = track * uniform_below( parameters.tracks / 2 + 1 );
+                        problem.capacityAdjustments.push_back( { x, y, z, x + 1, y, z, adjusted } );
+                    }
+
+                    if( problem.capacity.vertical[z] > 0 and y + 1 < parameters.y_grids and uniform_real() < parameters.adjustment_density ) {
+                        const int adjusted = track * uniform_below( parameters.tracks / 2 + 1 );
+                        problem.capacityAdjustments.push_back( { x, y, z, x, y + 1, z, adjusted } );
+                    }
+                }
+            }
+        }
+    }
+
+    return problem;
+}
+
+#endif
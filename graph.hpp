@@ -30,6 +30,10 @@ private:
     int dim_z;
 
     std::vector<int> capacities;
+
+    // for each layer, whether edges in x and y direction may be used at all 
+    std::vector<bool> x_usable;
+    std::vector<bool> y_usable;
     // std::vector<int> min_widths;
     // std::vector<int> min_spacings;
 
@@ -72,6 +76,7 @@ public:
     direction get_edge_direction( int edge_index ) const;
 
     std::vector<int> get_edgeindices_from_node( int nodeindex ) const;
+    std::vector<int> get_usable_edgeindices_from_node( int nodeindex ) const;
     int get_edgeindex_from_node_and_direction( int nodeindex, direction dir ) const;
     int get_edgeindex_from_nodes( int nodeindex1, int nodeindex2 ) const;
     
@@ -79,6 +84,31 @@ public:
     void set_capacity( int edgeindex, int new_capacity );
     const std::vector<int>& get_capacities() const;
 
+    // Directions that have no capacity on a layer can be excluded from the routing. 
+    // By default, all directions are usable. Edges in z direction are always usable. 
+    void set_direction_usable( int z, direction dir, bool usable );
+    bool is_direction_usable( int z, direction dir ) const;
+
+    // Strides of the node numbering and offsets of the edge blocks. 
+    // Search kernels that have decoded the position of a node once can compute 
+    // its neighbors and incident edges with these, without further divisions. 
+    struct Layout {
+        int dim_x;
+        int dim_y;
+        int dim_z;
+        int stride_x;
+        int stride_y;
+        int y_edges_offset;
+        int z_edges_offset;
+
+        // the edge from (x,y,z) in direction x_plus, y_plus, or z_plus 
+        int x_edge( int x, int y, int z ) const { return x * stride_x + y * stride_y + z; }
+        int y_edge( int x, int y, int z ) const { return y_edges_offset + y * dim_x * dim_z + x * dim_z + z; }
+        int z_edge( int x, int y, int z ) const { return z_edges_offset + z * dim_x * dim_y + x * dim_y + y; }
+    };
+
+    Layout get_layout() const;
+
     // int get_weight( int edgeindex ) const;
     // void set_weight( int edgeindex, int new_weight );
 };
@@ -104,7 +134,9 @@ Graph::Graph( int dim_x, int dim_y, int dim_z )
 dim_x(dim_x), 
 dim_y(dim_y), 
 dim_z(dim_z),
-capacities(0)
+capacities(0),
+x_usable( dim_z, true ),
+y_usable( dim_z, true )
 // min_widths(0)
 {
     assert( dim_x >= 1 && dim_y >= 1 && dim_z >= 1 );
@@ -340,6 +372,31 @@ std::vector<int> Graph::get_edgeindices_from_node( int nodeindex ) const
     return edges;
 }
 
+std::vector<int> Graph::get_usable_edgeindices_from_node( int nodeindex ) const 
+{
+    assert( nodeindex != invalid_index && 0 <= nodeindex && nodeindex < dim_x * dim_y * dim_z ); 
+    
+    const int z = nodeindex % dim_z;
+
+    std::vector<int> edges;
+    edges.reserve(6);
+    
+    for( int i = 0; i < 6; ++i ) {
+
+        direction dir = static_cast<direction>(i);
+
+        if( not is_direction_usable( z, dir ) ) continue;
+
+        if( not is_direction_possible( nodeindex, dir ) ) continue;
+        
+        edges.push_back( get_edgeindex_from_node_and_direction( nodeindex, dir ) );
+
+    }
+    
+    assert( edges.size() <= 6 );
+    return edges;
+}
+
 
 
 Graph::direction Graph::get_edge_direction( int edge_index ) const 
@@ -454,6 +511,34 @@ const std::vector<int>& Graph::get_capacities() const
     return capacities;
 }
 
+void Graph::set_direction_usable( int z, direction dir, bool usable )
+{
+    assert( 0 <= z && z < dim_z );
+    if( dir == direction::x_plus || dir == direction::x_minus ) x_usable[z] = usable;
+    if( dir == direction::y_plus || dir == direction::y_minus ) y_usable[z] = usable;
+}
+
+bool Graph::is_direction_usable( int z, direction dir ) const
+{
+    assert( 0 <= z && z < dim_z );
+    if( dir == direction::x_plus || dir == direction::x_minus ) return x_usable[z];
+    if( dir == direction::y_plus || dir == direction::y_minus ) return y_usable[z];
+    return true;
+}
+
+Graph::Layout Graph::get_layout() const
+{
+    Layout layout;
+    layout.dim_x          = dim_x;
+    layout.dim_y          = dim_y;
+    layout.dim_z          = dim_z;
+    layout.stride_x       = dim_y * dim_z;
+    layout.stride_y       = dim_z;
+    layout.y_edges_offset = (dim_x-1) * dim_y * dim_z;
+    layout.z_edges_offset = (dim_x-1) * dim_y * dim_z + dim_x * (dim_y-1) * dim_z;
+    return layout;
+}
+
 
 // int Graph::get_weight( int edgeindex ) const {
 //     assert( edgeindex >= 0 && edgeindex < static_cast<int>(min_widths.size()) );
@@ -11,6 +11,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #ifndef IG_GRP2GRAPH
 #define IG_GRP2GRAPH
 
+#include <algorithm>
+#include <vector>
+
 #include "common.hpp"
 
 #include "graph.hpp"
@@ -75,7 +78,8 @@ Graph createGraphFromGlobalRoutingProblem( const GlobalRoutingProblem &problem )
 
         assert( edgeindex != Graph::invalid_index && 0 <= edgeindex && edgeindex < graph.count_edges() );
 
-        assert( capAdj.adjusted_capacity <= graph.get_capacity( edgeindex ) );
+        // NOTE: an adjustment may also give capacity to an edge whose layer has none in that direction 
+        assert( capAdj.adjusted_capacity >= 0 );
         
         graph.set_capacity( edgeindex, capAdj.adjusted_capacity );
 
@@ -90,6 +94,28 @@ Graph createGraphFromGlobalRoutingProblem( const GlobalRoutingProblem &problem )
         
     }
 
+    // A direction without capacity on any edge of a layer, after the adjustments, is excluded there, 
+    // unless no layer has capacity in that direction at all 
+    {
+        const auto layout = graph.get_layout();
+
+        std::vector<char> horizontal( problem.grid.layers, false );
+        std::vector<char> vertical( problem.grid.layers, false );
+
+        // the layer is the remainder of the edge index in both planar blocks 
+        for( int e = 0; e < layout.y_edges_offset; e++ )              if( graph.get_capacity( e ) > 0 ) horizontal[ e % layout.dim_z ] = true;
+        for( int e = layout.y_edges_offset; e < layout.z_edges_offset; e++ ) if( graph.get_capacity( e ) > 0 ) vertical[ e % layout.dim_z ] = true;
+
+        const bool any_horizontal = std::find( horizontal.begin(), horizontal.end(), true ) != horizontal.end();
+        const bool any_vertical   = std::find( vertical.begin(),   vertical.end(),   true ) != vertical.end();
+
+        for( int z = 0; z < problem.grid.layers; ++z )
+        {
+            if( any_horizontal and not horizontal[z] ) graph.set_direction_usable( z, Graph::direction::x_plus, false );
+            if( any_vertical   and not vertical[z]   ) graph.set_direction_usable( z, Graph::direction::y_plus, false );
+        }
+    }
+
     for( int e = 0; e < graph.count_edges(); e++ )
     {
         auto cap = graph.get_capacity( e );
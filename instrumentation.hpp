@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef IG_INSTRUMENTATION
+#define IG_INSTRUMENTATION
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+// Instrumentation of the phases of a run: wall time, resident memory, and allocations. 
+// 
+// The allocations are counted by replacing the global operator new, including its array and over-aligned forms. 
+// The nothrow forms of the standard library call these. All forms of operator delete forward to the plain one. 
+// NOTE: this header replaces operator new and delete, hence it may only be included by the main file of an executable. 
+
+namespace allocation_counters 
+{
+    std::atomic<long> allocations     = 0;
+    std::atomic<long> allocated_bytes = 0;
+
+    // Memory from malloc or aligned_alloc, both released by free 
+    void* allocate( std::size_t size, std::size_t alignment )
+    {
+        allocations.fetch_add( 1, std::memory_order_relaxed );
+        allocated_bytes.fetch_add( size, std::memory_order_relaxed );
+
+        if( size == 0 ) size = 1;
+
+        // aligned_alloc requires a multiple of the alignment 
+        if( alignment > 0 ) size = ( size + alignment - 1 ) / alignment * alignment;
+
+        while( true ) {
+            void* pointer = ( alignment > 0 ) ? std::aligned_alloc( alignment, size ) : std::malloc( size );
+            if( pointer != nullptr ) return pointer;
+            const auto handler = std::get_new_handler();
+            if( handler == nullptr ) throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new( std::size_t size ) { return allocation_counters::allocate( size, 0 ); }
+void* operator new[]( std::size_t size ) { return allocation_counters::allocate( size, 0 ); }
+void* operator new( std::size_t size, std::align_val_t alignment ) { return allocation_counters::allocate( size, static_cast<std::size_t>( alignment ) ); }
+void* operator new[]( std::size_t size, std::align_val_t alignment ) { return allocation_counters::allocate( size, static_cast<std::size_t>( alignment ) ); }
+
+void operator delete( void* pointer ) noexcept { std::free( pointer ); }
+void operator delete[]( void* pointer ) noexcept { ::operator delete( pointer ); }
+void operator delete( void* pointer, std::size_t ) noexcept { ::operator delete( pointer ); }
+void operator delete[]( void* pointer, std::size_t ) noexcept { ::operator delete( pointer ); }
+void operator delete( void* pointer, std::align_val_t ) noexcept { ::operator delete( pointer ); }
+void operator delete[]( void* pointer, std::align_val_t ) noexcept { ::operator delete( pointer ); }
+void operator delete( void* pointer, std::size_t, std::align_val_t ) noexcept { ::operator delete( pointer ); }
+void operator delete[]( void* pointer, std::size_t, std::align_val_t ) noexcept { ::operator delete( pointer ); }
+
+
+
+// Current and peak resident memory of the process in bytes, from /proc/self/status, or 0 if not available. 
+
+std::pair<long,long> read_resident_memory()
+{
+    long rss = 0, peak_rss = 0;
+
+    std::FILE* file = std::fopen( "/proc/self/status", "r" );
+    if( file == nullptr ) return { 0, 0 };
+
+    char line[256];
+    while( std::fgets( line, sizeof(line), file ) != nullptr ) {
+        if( std::strncmp( line, "VmRSS:", 6 ) == 0 ) rss      = 1024 * std::atol( line + 6 );
+        if( std::strncmp( line, "VmHWM:", 6 ) == 0 ) peak_rss = 1024 * std::atol( line + 6 );
+    }
+
+    std::fclose( file );
+
+    return { rss, peak_rss };
+}
+
+
+
+// Measurements of the phases of a run, and further values such as the quality of the solution, 
+// which are written as one JSON object per run. 
+
+class InstrumentationReport
+{
+  public:
+
+    struct Phase {
+        std::string name;
+        double      seconds         = 0.;
+        long        rss_bytes       = 0;    // at the end of the phase 
+        long        peak_rss_bytes  = 0;    // of the process, up to the end of the phase 
+        long        allocations     = 0;
+        long        allocated_bytes = 0;
+    };
+
+    InstrumentationReport();
+
+    void begin_phase( const std::string& name );
+
+    void end_phase();
+
+    // values that describe the run, such as the instance or the overflow 
+    void add_value( const std::string& key, const std::string& value );
+    void add_value( const std::string& key, double value );
+
+    const std::vector<Phase>& get_phases() const { return phases; }
+
+    void log_phases( std::ostream& os ) const;
+
+    std::string to_json() const;
+
+    bool write_json( const std::string& filename ) const;
+
+  private:
+
+    std::chrono::steady_clock::time_point start_time;
+
+    // the phase that is running, if any 
+    Phase                                 current;
+    bool                                  in_phase = false;
+    std::chrono::steady_clock::time_point phase_start_time;
+
+    std::vector<Phase> phases;
+
+    // keys and values in JSON notation 
+    std::vector<std::pair<std::string,std::string>> values;
+};
+
+// Measures the enclosing scope as a phase of the report 
+
+class ScopedPhase
+{
+  public:
+
+    ScopedPhase( InstrumentationReport& report, const std::string& name ) : report( report ) { report.begin_phase( name ); }
+
+    ~ScopedPhase() { report.end_phase(); }
+
+    ScopedPhase( const ScopedPhase& )            = delete;
+    ScopedPhase& operator=( const ScopedPhase& ) = delete;
+
+  private:
+
+    InstrumentationReport& report;
+};
+
+// string in JSON notation, with quotes and escaped characters 
+std::string json_string( const std::string& text )
+{
+    std::string ret = "\"";
+    for( const char c : text ) {
+        if( c == '"' or c == '\\' ) { ret += '\\'; ret += c; }
+        else if( static_cast<unsigned char>( c ) < 0x20 ) { char code[8]; std::snprintf( code, sizeof(code), "\\u%04x", c ); ret += code; }
+        else ret += c;
+    }
+    return ret + "\"";
+}
+
+InstrumentationReport::InstrumentationReport()
+: start_time( std::chrono::steady_clock::now() )
+{}
+
+void InstrumentationReport::begin_phase( const std::string& name )
+{
+    assert( not in_phase );
+
+    in_phase                = true;
+    current                 = Phase();
+    current.name            = name;
+    current.allocations     = allocation_counters::allocations.load( std::memory_order_relaxed );
+    current.allocated_bytes = allocation_counters::allocated_bytes.load( std::memory_order_relaxed );
+    phase_start_time        = std::chrono::steady_clock::now();
+}
+
+void InstrumentationReport::end_phase()
+{
+    assert( in_phase );
+
+    current.seconds          = std::chrono::duration<double>( std::chrono::steady_clock::now() - phase_start_time ).count();
+    current.allocations      = allocation_counters::allocations.load( std::memory_order_relaxed ) - current.allocations;
+    current.allocated_bytes  = allocation_counters::allocated_bytes.load( std::memory_order_relaxed ) - current.allocated_bytes;
+    std::tie( current.rss_bytes, current.peak_rss_bytes ) = read_resident_memory();
+
+    phases.push_back( current );
+    in_phase = false;
+}
+
+void InstrumentationReport::add_value( const std::string& key, const std::string& value )
+{
+    values.emplace_back( key, json_string( value ) );
+}
+
+void InstrumentationReport::add_value( const std::string& key, double value )
+{
+    std::ostringstream text;
+    text.precision( 12 );
+    text << value;
+    values.emplace_back( key, text.str() );
+}
+
+void InstrumentationReport::log_phases( std::ostream& os ) const
+{
+    for( const auto& phase : phases ) {
+        os << "Phase " << phase.name << ": " << phase.seconds << "s" 
+           << "\t RSS: " << phase.rss_bytes / 1e6 << " MB\t peak RSS: " << phase.peak_rss_bytes / 1e6 << " MB"
+           << "\t allocations: " << phase.allocations << " (" << phase.allocated_bytes / 1e6 << " MB)" << nl;
+    }
+}
+
+std::string InstrumentationReport::to_json() const
+{
+    const double total_seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+    const auto [ rss, peak_rss ] = read_resident_memory();
+
+    std::ostringstream os;
+    os.precision( 12 );
+
+    os << "{\n";
+
+    for( const auto& [ key, value ] : values ) os << "  " << json_string( key ) << ": " << value << ",\n";
+
+    os << "  \"total_seconds\": "    << total_seconds << ",\n";
+    os << "  \"rss_bytes\": "        << rss << ",\n";
+    os << "  \"peak_rss_bytes\": "   << peak_rss << ",\n";
+    os << "  \"allocations\": "      << allocation_counters::allocations.load() << ",\n";
+    os << "  \"allocated_bytes\": "  << allocation_counters::allocated_bytes.load() << ",\n";
+
+    os << "  \"phases\": [";
+    for( int p = 0; p < phases.size(); p++ ) {
+        const auto& phase = phases[p];
+        os << ( p == 0 ? "\n" : ",\n" );
+        os << "    { \"name\": " << json_string( phase.name ) 
+           << ", \"seconds\": " << phase.seconds 
+           << ", \"rss_bytes\": " << phase.rss_bytes 
+           << ", \"peak_rss_bytes\": " << phase.peak_rss_bytes 
+           << ", \"allocations\": " << phase.allocations 
+           << ", \"allocated_bytes\": " << phase.allocated_bytes << " }";
+    }
+    os << "\n  ]\n";
+
+    os << "}\n";
+
+    return os.str();
+}
+
+bool InstrumentationReport::write_json( const std::string& filename ) const
+{
+    std::ofstream file( filename );
+    file << to_json();
+    return file.good();
+}
+
+#endif
@@ -8,7 +8,9 @@ The above copyright notice and this permission notice shall be included in all c
 THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -19,67 +21,206 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "common.hpp"
 #include "connector.hpp"
+#include "evaluator.hpp"
 #include "graph.hpp"
 #include "grp.hpp"
 #include "grp2graph.hpp"
+#include "instrumentation.hpp"
 #include "output_tree.hpp"
+#include "solution_store.hpp"
 
 int main( int argc, char* argv[] )
 {
-    const std::string filename = ( argc > 1 ) ? argv[1] : "adaptec1.capo70.2d.35.50.90.gr";
-
-    std::ifstream file( filename, std::ios_base::openmode::_S_in );
-
-    if( !file ) {
-        std::cerr << "Unable to open file: " << filename << "\n";
-        return 1;
-    } else {
-        std::clog << "Opened file: " << filename << "\n";
+    std::string filename = "adaptec1.capo70.2d.35.50.90.gr";
+
+    RoutingOptions options;
+
+    bool merge_segments = false;
+
+    std::string telemetryfilename;
+
+    std::string reportfilename;
+
+    for( int i = 1; i < argc; i++ ) {
+        const std::string argument = argv[i];
+
+        if( argument == "--threads" and i + 1 < argc ) {
+            options.num_threads = std::max( 1, std::atoi( argv[++i] ) );
+        } else if( argument == "--deterministic" ) {
+            options.deterministic = true;
+        } else if( argument == "--negotiation-rounds" and i + 1 < argc ) {
+            options.negotiation_rounds = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument == "--negotiation-seconds" and i + 1 < argc ) {
+            options.negotiation_seconds = std::atof( argv[++i] );
+        } else if( argument == "--no-pattern-routing" ) {
+            options.pattern_routing = false;
+        } else if( argument == "--no-steiner" ) {
+            options.steiner_decomposition = false;
+        } else if( argument == "--coarse" and i + 1 < argc ) {
+            options.coarse_tile_size = std::max( 0, std::atoi( argv[++i] ) );
+        } else if( argument == "--2d" ) {
+            options.projected = true;
+        } else if( argument == "--reference-kernel" ) {
+            options.reference_kernel = true;
+        } else if( argument == "--verify" ) {
+            options.verify = true;
+        } else if( argument == "--telemetry" and i + 1 < argc ) {
+            telemetryfilename = argv[++i];
+        } else if( argument == "--report" and i + 1 < argc ) {
+            reportfilename = argv[++i];
+        } else if( argument == "--merge-segments" ) {
+            merge_segments = true;
+        } else if( argument.starts_with( "--" ) ) {
+            std::cerr << "Unknown option: " << argument << "\n";
+            return 1;
+        } else {
+            filename = argument;
+        }
     }
 
+    // Each phase of the run is measured from the construction of its ScopedPhase to the end of the enclosing scope 
+    InstrumentationReport report;
+
     GlobalRoutingProblem problem;
-    problem.read( file );
-    file.close();
 
-    problem.heuristic_optimization();
+    {
+        ScopedPhase phase( report, "read" );
+
+        std::ifstream file( filename, std::ios_base::openmode::_S_in );
 
-    if( !problem.check() ) {
-        std::cerr << "Data verification failed.\n";
-        return 1;
+        if( !file ) {
+            std::cerr << "Unable to open file: " << filename << "\n";
+            return 1;
+        } else {
+            std::clog << "Opened file: " << filename << "\n";
+        }
+
+        problem.read( file );
+        file.close();
+    }
+
+    {
+        ScopedPhase phase( report, "heuristic_optimization" );
+        problem.heuristic_optimization();
     }
 
-    std::clog << "Data verification succeeded.\n";
+    {
+        ScopedPhase phase( report, "check" );
+
+        if( !problem.check() ) {
+            std::cerr << "Data verification failed.\n";
+            return 1;
+        }
+
+        std::clog << "Data verification succeeded.\n";
+    }
 
     // Convert to Graph
 
-    std::clog << "Create Graph from problem data.\n";
+    Graph graph = [&] {
+        ScopedPhase phase( report, "graph" );
+        std::clog << "Create Graph from problem data.\n";
+        return createGraphFromGlobalRoutingProblem( problem );
+    }();
 
-    Graph graph = createGraphFromGlobalRoutingProblem( problem );
+    Connector connector = [&] {
+        ScopedPhase phase( report, "initialize" );
+        std::clog << "Initialize routing class.\n";
+        return Connector( problem, graph, options );
+    }();
 
-    std::clog << "Initialize routing class.\n";
+    SolutionStore trees;
 
-    Connector connector = Connector( problem, graph );
+    {
+        ScopedPhase phase( report, "connect" );
+        trees = connector.connect();
+    }
 
-    const auto trees = connector.connect();
+    {
+        ScopedPhase phase( report, "negotiate" );
+        connector.negotiate( trees );
+    }
 
     std::clog << "Routing complete. \n";
 
+    if constexpr( log_level >= log_level_summary ) connector.get_telemetry().log_summary( std::clog );
+
+    if( not telemetryfilename.empty() ) {
+        if( not connector.get_telemetry().write_csv( telemetryfilename, problem ) ) {
+            std::cerr << "Unable to write telemetry file\n";
+            return 1;
+        }
+        std::clog << "Wrote telemetry: " << telemetryfilename << "\n";
+    }
+
+    Evaluation evaluation;
+
+    {
+        ScopedPhase phase( report, "evaluation" );
+
+        trees.compact();
+
+        const auto audit = connector.audit_capacities( trees );
+
+        std::clog << "Capacity audit: " << audit.overflowed_edges.size() << " overflowed edges used by " << audit.overflowed_nets.size() << " nets"
+                  << "\t mismatched edges: " << audit.mismatched_edges << "\t time: " << audit.seconds << "s\n";
+
+        if( audit.mismatched_edges > 0 ) {
+            std::cerr << "The usage of " << audit.mismatched_edges << " edges differs from the routed trees\n";
+            if( options.verify ) return 1;
+        }
+
+        if( options.verify ) {
+            const int invalid_trees = connector.count_invalid_trees( trees );
+            if( invalid_trees > 0 ) {
+                std::cerr << "Verification failed for " << invalid_trees << " nets\n";
+                return 1;
+            }
+            std::clog << "Verification: the edges of every net form a tree that connects its pins\n";
+        }
+
+        std::clog << "Solution: " << trees.count_edges() << " edges of " << trees.count_nets() << " nets in " << trees.memory_bytes() / 1e6 << " MB"
+                  << "\t as one set per net: " << trees.memory_bytes_as_sets() / 1e6 << " MB\n";
+
+        const Evaluator evaluator( problem, graph );
+
+        evaluation = evaluator.evaluate( connector.get_aggregated_width(), trees );
+
+        std::clog << evaluation << "\n";
+    }
+
     // Write the data to an output file
     const std::string outputfilename = generate_new_filename( filename + ".solution" );
-    std::ofstream     outfile( outputfilename, std::ios_base::openmode::_S_out );
 
-    if( !outfile ) {
-        std::cerr << "Unable to open output file\n";
-        return 1;
-    } else {
-        std::clog << "Opened file: " << outputfilename << "\n";
-    }
+    {
+        ScopedPhase phase( report, "output" );
+
+        const SolutionWriter writer( problem, graph, merge_segments );
 
-    for( int n = 0; n < problem.nets.size(); n++ ) {
-        output_tree_for_net( outfile, problem, graph, n, trees[n] );
+        if( not writer.write( outputfilename, trees, options.num_threads ) ) {
+            std::cerr << "Unable to write output file\n";
+            return 1;
+        } else {
+            std::clog << "Wrote file: " << outputfilename << "\n";
+        }
     }
 
-    outfile.close();
+    if constexpr( log_level >= log_level_summary ) report.log_phases( std::clog );
+
+    if( not reportfilename.empty() ) {
+        report.add_value( "instance", filename );
+        report.add_value( "threads", options.num_threads );
+        report.add_value( "nets", trees.count_nets() );
+        report.add_value( "edges", trees.count_edges() );
+        report.add_value( "total_overflow", evaluation.total_overflow );
+        report.add_value( "max_overflow", evaluation.max_overflow );
+        report.add_value( "wirelength", evaluation.total_wirelength() );
+        if( not report.write_json( reportfilename ) ) {
+            std::cerr << "Unable to write report file\n";
+            return 1;
+        }
+        std::clog << "Wrote report: " << reportfilename << "\n";
+    }
 
     std::clog << "Finished. \n";
 
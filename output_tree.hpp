@@ -11,22 +11,35 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #ifndef IG_OUTPUT
 #define IG_OUTPUT
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
 #include <ostream>
-#include <set>
+#include <span>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "common.hpp"
 #include "graph.hpp"
 #include "grp.hpp"
+#include "scheduler.hpp"
+#include "solution_store.hpp"
 
-void output_tree_for_net( std::ostream& os, const GlobalRoutingProblem& grp, const Graph& graph, const int net_index, const std::set<int>& tree )
+void output_tree_for_net( std::ostream& os, const GlobalRoutingProblem& grp, const Graph& graph, const int net_index, std::span<const int> tree )
 {
     assert( 0 <= net_index && net_index < grp.nets.size() );
 
     // Print the name and the id# of the net with index `net_index`
-    const auto net = grp.nets[net_index];
+    const auto& net = grp.nets[net_index];
 
-    os << net.name << " " << net.id << " " << tree.size() << std::endl;
+    os << net.name << " " << net.id << " " << tree.size() << "\n";
 
     // Print the respective edges
 
@@ -66,16 +79,380 @@ void output_tree_for_net( std::ostream& os, const GlobalRoutingProblem& grp, con
         z_f++;
         z_t++;
 
-        os << "(" << x_f << "," << y_f << "," << z_f << ")-(" << x_t << "," << y_t << "," << z_t << ")" << std::endl;
+        os << "(" << x_f << "," << y_f << "," << z_f << ")-(" << x_t << "," << y_t << "," << z_t << ")" << "\n";
     }
 
     // Finish the tree with an exclamation mark
 
-    os << "!" << std::endl << std::endl;
+    os << "!\n\n";
 
     // std::clog << "Completed file output" << std::endl << std::endl;
 
     return;
 }
 
+
+
+// Writer of solution files that produces the same output as `output_tree_for_net`. 
+// 
+// The coordinates of the tile centers and the layer numbers are formatted once, with std::to_chars, 
+// so that each edge only copies a few short strings. The records are collected in large buffers, 
+// which are written to the file with few system calls. 
+// 
+// With several threads, the nets are split into contiguous ranges. The size of each range in the file 
+// is computed first, so that every thread formats its ranges and writes them to their final position. 
+// 
+// Optionally, collinear consecutive edges of a tree are merged into one segment across several tiles. 
+// A segment only ends at a tile where the tree branches, ends, or has a pin. 
+
+class SolutionWriter
+{
+  public:
+
+    SolutionWriter( const GlobalRoutingProblem& grp, const Graph& graph, bool merge_segments = false );
+
+    // `length` edges from the node (x,y,z) in the direction (dx,dy,dz) 
+    struct Segment {
+        int x, y, z;
+        int dx, dy, dz;
+        int length;
+    };
+
+    // working memory of one thread 
+    struct Scratch {
+        StampedIndexSet      tree_edges;
+        std::vector<Segment> segments;
+    };
+
+    Scratch create_scratch() const;
+
+    // the segments of the tree, in the order of their first edges 
+    void collect_segments( Scratch& scratch, int net_index, std::span<const int> tree ) const;
+
+    // append the record of a net to the buffer 
+    void format_net( Scratch& scratch, std::string& buffer, int net_index, std::span<const int> tree ) const;
+
+    // the number of bytes that `format_net` appends 
+    std::size_t count_net_bytes( Scratch& scratch, int net_index, std::span<const int> tree ) const;
+
+    // Write the records of all nets to the file. Returns false if the file cannot be written. 
+    bool write( const std::string& filename, const SolutionStore& trees, int num_threads = 1 ) const;
+
+    // the buffer of a thread is written whenever it holds this many bytes 
+    static const std::size_t buffer_bytes;
+
+    // number of ranges of nets per thread 
+    static const int ranges_per_thread;
+
+  private:
+
+    // the lower node of an edge, and the direction towards the upper node 
+    void decode_edge( int edgeindex, int& x, int& y, int& z, int& dx, int& dy, int& dz ) const;
+
+    const GlobalRoutingProblem& grp;
+    const Graph::Layout         layout;
+    const int                   num_edges;
+    const bool                  merge_segments;
+
+    // the nodes of the pins of each net, only if segments are merged 
+    std::vector<int> pin_offsets;
+    std::vector<int> pin_nodes;
+
+    // formatted centers of the tiles in each direction, and one-based layer numbers 
+    std::vector<std::string> x_text;
+    std::vector<std::string> y_text;
+    std::vector<std::string> z_text;
+};
+
+const std::size_t SolutionWriter::buffer_bytes = 1 << 22;
+
+const int SolutionWriter::ranges_per_thread = 8;
+
+SolutionWriter::SolutionWriter( const GlobalRoutingProblem& grp, const Graph& graph, bool merge_segments )
+: grp( grp ), layout( graph.get_layout() ), num_edges( graph.count_edges() ), merge_segments( merge_segments )
+{
+    const auto format = []( int value ) -> std::string {
+        char text[16];
+        const auto result = std::to_chars( text, text + sizeof(text), value );
+        assert( result.ec == std::errc() );
+        return std::string( text, result.ptr );
+    };
+
+    for( int x = 0; x < layout.dim_x; x++ ) x_text.push_back( format( grp.center_of_tile( x, 0 ).first ) );
+    for( int y = 0; y < layout.dim_y; y++ ) y_text.push_back( format( grp.center_of_tile( 0, y ).second ) );
+    for( int z = 0; z < layout.dim_z; z++ ) z_text.push_back( format( z + 1 ) );
+
+    if( merge_segments ) {
+        pin_offsets.push_back( 0 );
+        for( const auto& net : grp.nets ) {
+            for( const auto& pin : net.pins ) {
+                const auto tile_xy = grp.tile_of_coordinate( pin.x, pin.y );
+                pin_nodes.push_back( graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer ) );
+            }
+            std::sort( pin_nodes.begin() + pin_offsets.back(), pin_nodes.end() );
+            pin_offsets.push_back( pin_nodes.size() );
+        }
+    }
+}
+
+SolutionWriter::Scratch SolutionWriter::create_scratch() const
+{
+    Scratch scratch;
+    if( merge_segments ) scratch.tree_edges.resize( num_edges );
+    return scratch;
+}
+
+void SolutionWriter::collect_segments( Scratch& scratch, int net_index, std::span<const int> tree ) const
+{
+    assert( 0 <= net_index && net_index < grp.nets.size() );
+
+    auto& segments = scratch.segments;
+    segments.clear();
+
+    if( not merge_segments ) {
+        for( const int edgeindex : tree ) {
+            Segment segment;
+            decode_edge( edgeindex, segment.x, segment.y, segment.z, segment.dx, segment.dy, segment.dz );
+            segment.length = 1;
+            segments.push_back( segment );
+        }
+        return;
+    }
+
+    auto& tree_edges = scratch.tree_edges;
+    assert( tree_edges.bound() == num_edges );
+
+    tree_edges.clear();
+    for( const int edgeindex : tree ) tree_edges.insert( edgeindex );
+
+    const auto pins_begin = pin_nodes.begin() + pin_offsets[net_index];
+    const auto pins_end   = pin_nodes.begin() + pin_offsets[net_index+1];
+
+    // A segment ends at every node whose degree in the tree is not two, and at every pin 
+
+    const auto is_segment_end = [&]( int x, int y, int z ) -> bool {
+        if( std::binary_search( pins_begin, pins_end, x * layout.stride_x + y * layout.stride_y + z ) ) return true;
+        int degree = 0;
+        if( x > 0 )                degree += tree_edges.contains( layout.x_edge( x-1, y, z ) );
+        if( x < layout.dim_x - 1 ) degree += tree_edges.contains( layout.x_edge( x,   y, z ) );
+        if( y > 0 )                degree += tree_edges.contains( layout.y_edge( x, y-1, z ) );
+        if( y < layout.dim_y - 1 ) degree += tree_edges.contains( layout.y_edge( x, y,   z ) );
+        if( z > 0 )                degree += tree_edges.contains( layout.z_edge( x, y, z-1 ) );
+        if( z < layout.dim_z - 1 ) degree += tree_edges.contains( layout.z_edge( x, y, z   ) );
+        return degree != 2;
+    };
+
+    // Each segment is reported at its first edge, and extended along its direction as long as possible 
+
+    for( const int edgeindex : tree ) {
+        Segment segment;
+        auto& [ x, y, z, dx, dy, dz, length ] = segment;
+        decode_edge( edgeindex, x, y, z, dx, dy, dz );
+
+        // distance between the indices of consecutive edges in the same direction 
+        const int step = dx ? layout.stride_x : dy ? layout.dim_x * layout.dim_z : layout.dim_x * layout.dim_y;
+
+        const int position = dx ? x : dy ? y : z;
+        const int extent   = dx ? layout.dim_x : dy ? layout.dim_y : layout.dim_z;
+
+        if( position > 0 and tree_edges.contains( edgeindex - step ) and not is_segment_end( x, y, z ) ) continue;
+
+        length = 1;
+        while( position + length + 1 < extent 
+               and tree_edges.contains( edgeindex + length * step ) 
+               and not is_segment_end( x + length * dx, y + length * dy, z + length * dz ) ) 
+            length++;
+
+        segments.push_back( segment );
+    }
+}
+
+void SolutionWriter::format_net( Scratch& scratch, std::string& buffer, int net_index, std::span<const int> tree ) const
+{
+    assert( 0 <= net_index && net_index < grp.nets.size() );
+
+    collect_segments( scratch, net_index, tree );
+
+    const auto& net = grp.nets[net_index];
+
+    char text[16];
+
+    buffer += net.name;
+    buffer += ' ';
+    buffer.append( text, std::to_chars( text, text + sizeof(text), net.id ).ptr );
+    buffer += ' ';
+    buffer.append( text, std::to_chars( text, text + sizeof(text), scratch.segments.size() ).ptr );
+    buffer += '\n';
+
+    for( const auto& [ x, y, z, unit_dx, unit_dy, unit_dz, length ] : scratch.segments )
+    {
+        const int dx = unit_dx * length, dy = unit_dy * length, dz = unit_dz * length;
+
+        buffer += '(';
+        buffer += x_text[x];
+        buffer += ',';
+        buffer += y_text[y];
+        buffer += ',';
+        buffer += z_text[z];
+        buffer += ")-(";
+        buffer += x_text[x+dx];
+        buffer += ',';
+        buffer += y_text[y+dy];
+        buffer += ',';
+        buffer += z_text[z+dz];
+        buffer += ")\n";
+    }
+
+    buffer += "!\n\n";
+}
+
+std::size_t SolutionWriter::count_net_bytes( Scratch& scratch, int net_index, std::span<const int> tree ) const
+{
+    assert( 0 <= net_index && net_index < grp.nets.size() );
+
+    collect_segments( scratch, net_index, tree );
+
+    const auto& net = grp.nets[net_index];
+
+    char text[16];
+
+    std::size_t ret = net.name.size() + 3;
+    ret += std::to_chars( text, text + sizeof(text), net.id ).ptr - text;
+    ret += std::to_chars( text, text + sizeof(text), scratch.segments.size() ).ptr - text;
+
+    for( const auto& [ x, y, z, unit_dx, unit_dy, unit_dz, length ] : scratch.segments )
+    {
+        const int dx = unit_dx * length, dy = unit_dy * length, dz = unit_dz * length;
+
+        ret += x_text[x].size() + y_text[y].size() + z_text[z].size() 
+             + x_text[x+dx].size() + y_text[y+dy].size() + z_text[z+dz].size() + 10;
+    }
+
+    return ret + 3;
+}
+
+void SolutionWriter::decode_edge( int edgeindex, int& x, int& y, int& z, int& dx, int& dy, int& dz ) const
+{
+    int e = edgeindex;
+    dx = dy = dz = 0;
+
+    if( e < layout.y_edges_offset ) {
+        dx = 1;
+        x = e / layout.stride_x; e -= x * layout.stride_x;
+        y = e / layout.stride_y; e -= y * layout.stride_y;
+        z = e;
+    } else if( e < layout.z_edges_offset ) {
+        dy = 1;
+        e -= layout.y_edges_offset;
+        y = e / ( layout.dim_x * layout.dim_z ); e -= y * layout.dim_x * layout.dim_z;
+        x = e / layout.dim_z;                    e -= x * layout.dim_z;
+        z = e;
+    } else {
+        dz = 1;
+        e -= layout.z_edges_offset;
+        z = e / ( layout.dim_x * layout.dim_y ); e -= z * layout.dim_x * layout.dim_y;
+        x = e / layout.dim_y;                    e -= x * layout.dim_y;
+        y = e;
+    }
+
+    assert( layout.dim_x > x + dx and layout.dim_y > y + dy and layout.dim_z > z + dz );
+}
+
+bool SolutionWriter::write( const std::string& filename, const SolutionStore& trees, int num_threads ) const
+{
+    assert( trees.count_nets() == grp.nets.size() );
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    WorkStealingScheduler scheduler( num_threads );
+
+    // split the nets into contiguous ranges of about the same number of edges 
+
+    const int num_ranges = std::max( 1, std::min( trees.count_nets(), scheduler.count_threads() * ranges_per_thread ) );
+
+    std::vector<int> range_start = { 0 };
+    {
+        const long total_lines = trees.count_edges() + 2L * trees.count_nets();
+        long lines = 0;
+        for( int n = 0; n < trees.count_nets(); n++ ) {
+            lines += trees.edges_of( n ).size() + 2;
+            if( lines * num_ranges >= total_lines * (long)range_start.size() and range_start.size() < num_ranges ) range_start.push_back( n + 1 );
+        }
+        if( range_start.back() != trees.count_nets() ) range_start.push_back( trees.count_nets() );
+    }
+
+    std::vector<int>    ranges( range_start.size() - 1 );
+    std::vector<double> costs( ranges.size() );
+    for( int r = 0; r < ranges.size(); r++ ) {
+        ranges[r] = r;
+        costs[r]  = range_start[r+1] - range_start[r];
+    }
+
+    // the position of each range in the file 
+
+    std::vector<long> range_offset( range_start.size(), 0 );
+
+    std::vector<Scratch> scratches;
+    for( int t = 0; t < scheduler.count_threads(); t++ ) scratches.push_back( create_scratch() );
+
+    scheduler.run( ranges, costs, [&]( int thread_index, int r ) -> void {
+        long bytes = 0;
+        for( int n = range_start[r]; n < range_start[r+1]; n++ ) bytes += count_net_bytes( scratches[thread_index], n, trees.edges_of( n ) );
+        range_offset[r+1] = bytes;
+    });
+
+    for( int r = 0; r < ranges.size(); r++ ) range_offset[r+1] += range_offset[r];
+
+    const long total_bytes = range_offset.back();
+
+    const int fd = ::open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+    if( fd < 0 ) return false;
+
+    std::atomic<bool> success = ( ::ftruncate( fd, total_bytes ) == 0 );
+
+    // every thread formats its ranges into its own buffer, and writes them to their position 
+
+    std::vector<std::string> buffers( scheduler.count_threads() );
+
+    scheduler.run( ranges, costs, [&]( int thread_index, int r ) -> void {
+
+        auto& buffer = buffers[thread_index];
+        buffer.clear();
+        buffer.reserve( buffer_bytes + ( 1 << 16 ) );
+
+        long offset = range_offset[r];
+
+        const auto flush = [&]() -> void {
+            const char* data      = buffer.data();
+            std::size_t remaining = buffer.size();
+            while( success and remaining > 0 ) {
+                const ssize_t written = ::pwrite( fd, data, remaining, offset );
+                if( written <= 0 ) { success = false; break; }
+                data      += written;
+                remaining -= written;
+                offset    += written;
+            }
+            buffer.clear();
+        };
+
+        for( int n = range_start[r]; n < range_start[r+1]; n++ )
+        {
+            format_net( scratches[thread_index], buffer, n, trees.edges_of( n ) );
+            if( buffer.size() >= buffer_bytes ) flush();
+        }
+
+        flush();
+
+        assert( not success or offset == range_offset[r+1] );
+    });
+
+    if( ::close( fd ) != 0 ) success = false;
+
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+    std::clog << "Solution output: " << total_bytes / 1e6 << " MB in " << seconds << "s with " << scheduler.count_threads() << " threads" << nl;
+
+    return success;
+}
+
 #endif
@@ -43,6 +43,27 @@ class PriorityQueue
 
     vector<Entry> heap;
 
+    // Position of each value in the heap, or -1 if the value is not queued. 
+    // The values are non-negative and index this vector, which grows with the largest value.
+    vector<int> position;
+
+    // Swap two heap entries and update their positions
+    void swapEntries( int i, int j )
+    {
+        swap( heap[i], heap[j] );
+        position[heap[i].value] = i;
+        position[heap[j].value] = j;
+    }
+
+    // Index of a value in the heap, or -1
+    int find( Valuetype value ) const
+    {
+        assert( value >= 0 );
+        if( value >= position.size() ) return -1;
+        assert( position[value] == -1 || heap[position[value]].value == value );
+        return position[value];
+    }
+
     // Helper function for maintaining heap properties:
     // move item up as much as possible
     int heapifyUp( int index )
@@ -53,7 +74,7 @@ class PriorityQueue
             int parent = ( index - 1 ) / 2;
 
             if( heap[index] < heap[parent] ) {
-                swap( heap[index], heap[parent] );
+                swapEntries( index, parent );
                 index = parent;
             } else {
                 break;
@@ -84,7 +105,7 @@ class PriorityQueue
             }
 
             if( smallest != index ) {
-                swap( heap[index], heap[smallest] );
+                swapEntries( index, smallest );
                 index = smallest;
             } else {
                 break;
@@ -122,6 +143,7 @@ class PriorityQueue
     // Clear the queue completey
     void clear()
     {
+        for( const auto& entry : heap ) position[entry.value] = -1;
         heap.clear();
         assert( heap.size() == 0 );
     }
@@ -129,7 +151,7 @@ class PriorityQueue
     // Check whether any entry has a given value
     bool contains( Valuetype value ) const
     {
-        return any_of( heap.begin(), heap.end(), [value]( const Entry& entry ) { return entry.value == value; } );
+        return find( value ) != -1;
     }
 
     // peek the top entry
@@ -148,12 +170,12 @@ class PriorityQueue
     // Get the priority of any given value
     Prioritytype getPriority( Valuetype value ) const
     {
-        auto it = find_if( heap.begin(), heap.end(), [value]( const Entry& entry ) { return entry.value == value; } );
+        const int index = find( value );
 
-        assert( it != heap.end() );
+        assert( index != -1 );
 
-        if( it != heap.end() ) {
-            return it->priority;
+        if( index != -1 ) {
+            return heap[index].priority;
         } else {
             cerr << "Value not found in priority queue!" << endl;
             exit( 1 );
@@ -164,8 +186,14 @@ class PriorityQueue
     // NOTE: it is inserted at the end, so we need to move it up
     void push( valuetype value, prioritytype priority )
     {
+        assert( value >= 0 );
+        assert( not contains( value ) );
+
+        if( value >= position.size() ) position.resize( value + 1, -1 );
+
         Entry entry = { value, priority };
         heap.push_back( entry );
+        position[value] = heap.size() - 1;
         heapifyUp( heap.size() - 1 );
     }
 
@@ -184,7 +212,12 @@ class PriorityQueue
         heap[0]   = heap.back();
         heap.pop_back();
 
-        if( not heap.empty() ) heapifyDown( 0 );
+        position[top.value] = -1;
+
+        if( not heap.empty() ) {
+            position[heap[0].value] = 0;
+            heapifyDown( 0 );
+        }
 
         return top;
     }
@@ -193,37 +226,39 @@ class PriorityQueue
     void remove( Valuetype value )
     {
         // Find the index of the entry with the given value
-        auto it = find_if( heap.begin(), heap.end(), [value]( const Entry& entry ) { return entry.value == value; } );
+        const int index = find( value );
 
-        assert( it != heap.end() );
+        assert( index != -1 );
 
-        if( it != heap.end() ) {
-            int index = it - heap.begin();
+        if( index != -1 ) {
 
             // Swap the entry with the last element and remove it
-            *it = heap.back();
+            position[value] = -1;
+            heap[index]     = heap.back();
             heap.pop_back();
 
             // Re-heapify to maintain heap property
-            // if( not heap.empty() ) heapifyDown( it - heap.begin() );
-            if( not heap.empty() ) heapifyDown( index );
+            // NOTE: the last element may belong above or below the removed one
+            if( index < heap.size() ) {
+                position[heap[index].value] = index;
+                heapifyDown( heapifyUp( index ) );
+            }
         }
     }
 
     // Set the priority of any given value
     void setPriority( Valuetype value, Prioritytype new_priority )
     {
-        auto it = find_if( heap.begin(), heap.end(), [value]( const Entry& entry ) { return entry.value == value; } );
+        const int index = find( value );
 
-        assert( it != heap.end() );
+        assert( index != -1 );
 
-        if( it != heap.end() ) {
-            auto old_priority = it->priority;
+        if( index != -1 ) {
+            auto old_priority = heap[index].priority;
 
-            it->priority = new_priority;
+            heap[index].priority = new_priority;
 
             // Re-heapify to maintain heap property
-            int index = it - heap.begin();
 
             // heapifyUp(index);
             // heapifyDown(index);
@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef IG_PROJECTION
+#define IG_PROJECTION
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "common.hpp"
+
+#include "graph.hpp"
+#include "grp.hpp"
+
+// Projection of a routing problem onto a single layer. 
+// 
+// The capacity of each planar edge is the sum of the capacities of the edges above each other, 
+// as given by the graph of the original problem, including its capacity adjustments. 
+// The minimum widths and spacings are the smallest ones over all layers. 
+// All pins are moved to the single layer, and the nets keep their order. 
+
+GlobalRoutingProblem project_to_2d( const GlobalRoutingProblem& problem, const Graph& graph )
+{
+    GlobalRoutingProblem ret;
+
+    const int layers = problem.grid.layers;
+
+    ret.grid     = { problem.grid.x_grids, problem.grid.y_grids, 1 };
+    ret.tileInfo = problem.tileInfo;
+
+    int horizontal = 0;
+    int vertical   = 0;
+    for( int z = 0; z < layers; z++ ) {
+        horizontal += problem.capacity.horizontal[z];
+        vertical   += problem.capacity.vertical[z];
+    }
+    ret.capacity.horizontal = { horizontal };
+    ret.capacity.vertical   = { vertical   };
+
+    ret.dimension.minimum_width   = { *std::min_element( problem.dimension.minimum_width.begin(),   problem.dimension.minimum_width.end()   ) };
+    ret.dimension.minimum_spacing = { *std::min_element( problem.dimension.minimum_spacing.begin(), problem.dimension.minimum_spacing.end() ) };
+    ret.dimension.via_spacing     = { *std::min_element( problem.dimension.via_spacing.begin(),     problem.dimension.via_spacing.end()     ) };
+
+    ret.nets = problem.nets;
+    for( auto& net : ret.nets )
+    for( auto& pin : net.pins ) 
+        pin.layer = 0;
+
+    // every planar edge whose summed capacity is reduced gets an adjustment 
+
+    for( int x = 0; x < problem.grid.x_grids; x++ )
+    for( int y = 0; y < problem.grid.y_grids; y++ )
+    for( const auto dir : { Graph::direction::x_plus, Graph::direction::y_plus } )
+    {
+        const int nodeindex = graph.get_nodeindex_from_position( x, y, 0 );
+        
+        if( not graph.is_direction_possible( nodeindex, dir ) ) continue;
+
+        int capacity = 0;
+        for( int z = 0; z < layers; z++ ) {
+            const int edgeindex = graph.get_edgeindex_from_node_and_direction( graph.get_nodeindex_from_position( x, y, z ), dir );
+            capacity += graph.get_capacity( edgeindex );
+        }
+
+        const int default_capacity = ( dir == Graph::direction::x_plus ) ? horizontal : vertical;
+
+        assert( capacity <= default_capacity );
+
+        if( capacity == default_capacity ) continue;
+
+        if( dir == Graph::direction::x_plus )
+            ret.capacityAdjustments.push_back( { x, y, 0, x + 1, y, 0, capacity } );
+        else 
+            ret.capacityAdjustments.push_back( { x, y, 0, x, y + 1, 0, capacity } );
+    }
+
+    return ret;
+}
+
+#endif
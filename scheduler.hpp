@@ -0,0 +1,234 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef IG_SCHEDULER
+#define IG_SCHEDULER
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+
+// Work-stealing scheduler for tasks whose costs differ by orders of magnitude.
+//
+// Every worker owns a deque of tasks. Before a run, the tasks are distributed over the deques
+// by their estimated cost (largest first onto the least loaded deque), but each deque keeps
+// the tasks in their original order. A worker takes tasks from the front of its own deque.
+// Once its deque is empty, it steals from the back of the other deques.
+//
+// The worker threads are kept alive between runs. The calling thread acts as worker 0.
+
+class WorkStealingScheduler
+{
+  public:
+
+    explicit WorkStealingScheduler( int num_threads );
+
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler( const WorkStealingScheduler& )            = delete;
+    WorkStealingScheduler& operator=( const WorkStealingScheduler& ) = delete;
+
+    int count_threads() const { return num_threads; }
+
+    // Calls `work( thread_index, task )` once for every task and returns when all are done.
+    // The vector `costs` holds one estimate per task and only affects the initial placement.
+    void run( const std::vector<int>& tasks, const std::vector<double>& costs, const std::function<void( int, int )>& work );
+
+    // Statistics of the last run
+    double              get_wall_seconds() const { return wall_seconds; }
+    std::vector<double> get_utilization() const;
+    int                 count_steals() const;
+
+  private:
+
+    struct WorkerQueue {
+        std::mutex      mutex;
+        std::deque<int> tasks;
+        double          busy_seconds = 0.;
+        int             steals       = 0;
+    };
+
+    int num_threads;
+
+    std::vector<WorkerQueue> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex              control_mutex;
+    std::condition_variable start_signal;
+    std::condition_variable finish_signal;
+    long                    generation       = 0;
+    int                     active_workers   = 0;
+    bool                    shutting_down    = false;
+    const std::function<void( int, int )>* current_work = nullptr;
+
+    double wall_seconds = 0.;
+
+    bool take_task( int thread_index, int& task );
+
+    void work_until_empty( int thread_index );
+
+    void worker_loop( int thread_index );
+};
+
+WorkStealingScheduler::WorkStealingScheduler( int num_threads )
+: num_threads( std::max( 1, num_threads ) ), queues( std::max( 1, num_threads ) )
+{
+    for( int t = 1; t < this->num_threads; t++ ) {
+        threads.emplace_back( &WorkStealingScheduler::worker_loop, this, t );
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock( control_mutex );
+        shutting_down = true;
+    }
+    start_signal.notify_all();
+    for( auto& thread : threads ) thread.join();
+}
+
+void WorkStealingScheduler::run( const std::vector<int>& tasks, const std::vector<double>& costs, const std::function<void( int, int )>& work )
+{
+    assert( tasks.size() == costs.size() );
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Initial placement: assign the tasks, most expensive first, to the least loaded queue.
+    // Afterwards, every queue is restored to the original order of the tasks.
+    std::vector<int> order( tasks.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::stable_sort( order.begin(), order.end(), [&]( int a, int b ) { return costs[a] > costs[b]; } );
+
+    std::vector<double>           load( num_threads, 0. );
+    std::vector<std::vector<int>> assigned( num_threads );
+
+    for( const int i : order ) {
+        const int t = std::min_element( load.begin(), load.end() ) - load.begin();
+        load[t] += costs[i];
+        assigned[t].push_back( i );
+    }
+
+    for( int t = 0; t < num_threads; t++ ) {
+        std::sort( assigned[t].begin(), assigned[t].end() );
+        queues[t].tasks.clear();
+        for( const int i : assigned[t] ) queues[t].tasks.push_back( tasks[i] );
+        queues[t].busy_seconds = 0.;
+        queues[t].steals       = 0;
+    }
+
+    // Wake up the worker threads and join in as worker 0
+
+    {
+        std::lock_guard<std::mutex> lock( control_mutex );
+        current_work   = &work;
+        active_workers = num_threads - 1;
+        generation++;
+    }
+    start_signal.notify_all();
+
+    work_until_empty( 0 );
+
+    {
+        std::unique_lock<std::mutex> lock( control_mutex );
+        finish_signal.wait( lock, [this] { return active_workers == 0; } );
+        current_work = nullptr;
+    }
+
+    wall_seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+}
+
+bool WorkStealingScheduler::take_task( int thread_index, int& task )
+{
+    {
+        auto&                       own = queues[thread_index];
+        std::lock_guard<std::mutex> lock( own.mutex );
+        if( not own.tasks.empty() ) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for( int offset = 1; offset < num_threads; offset++ ) {
+        auto&                       victim = queues[( thread_index + offset ) % num_threads];
+        std::lock_guard<std::mutex> lock( victim.mutex );
+        if( not victim.tasks.empty() ) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            queues[thread_index].steals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingScheduler::work_until_empty( int thread_index )
+{
+    assert( current_work != nullptr );
+
+    // No task creates new tasks, so once all queues are empty, there is nothing left to do
+    int task;
+    while( take_task( thread_index, task ) ) {
+        const auto task_start = std::chrono::steady_clock::now();
+        ( *current_work )( thread_index, task );
+        queues[thread_index].busy_seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - task_start ).count();
+    }
+}
+
+void WorkStealingScheduler::worker_loop( int thread_index )
+{
+    long seen_generation = 0;
+
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock( control_mutex );
+            start_signal.wait( lock, [&] { return shutting_down or generation != seen_generation; } );
+            if( shutting_down ) return;
+            seen_generation = generation;
+        }
+
+        work_until_empty( thread_index );
+
+        {
+            std::lock_guard<std::mutex> lock( control_mutex );
+            active_workers--;
+        }
+        finish_signal.notify_one();
+    }
+}
+
+std::vector<double> WorkStealingScheduler::get_utilization() const
+{
+    std::vector<double> ret( num_threads, 0. );
+    for( int t = 0; t < num_threads; t++ ) {
+        ret[t] = ( wall_seconds > 0. ) ? queues[t].busy_seconds / wall_seconds : 0.;
+    }
+    return ret;
+}
+
+int WorkStealingScheduler::count_steals() const
+{
+    int ret = 0;
+    for( const auto& queue : queues ) ret += queue.steals;
+    return ret;
+}
+
+#endif
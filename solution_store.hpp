@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef IG_SOLUTION_STORE
+#define IG_SOLUTION_STORE
+
+#include <cassert>
+#include <cstddef>
+#include <set>
+#include <span>
+#include <vector>
+
+#include "common.hpp"
+
+// Edges of the routed nets in compressed form. 
+// 
+// The edges of all nets are kept in one array, and each net refers to a range of it. 
+// Replacing the edges of a net appends a new range, and the old range becomes unused. 
+// Once more than half of the array is unused, the ranges are moved together in the order of the nets. 
+
+class SolutionStore
+{
+  public:
+
+    explicit SolutionStore( int num_nets = 0 );
+
+    int count_nets() const { return sizes.size(); }
+
+    // the number of edges of all nets 
+    long count_edges() const { return used_edges; }
+
+    std::span<const int> edges_of( int net_index ) const;
+
+    void assign( int net_index, std::span<const int> net_edges );
+
+    void compact();
+
+    std::size_t memory_bytes() const;
+
+    // Estimated memory of the same solution as a `std::set<int>` per net. 
+    // A node of a red-black tree holds three pointers, the color, and the value, 
+    // which the allocator rounds up to 48 bytes. 
+    std::size_t memory_bytes_as_sets() const;
+
+  private:
+
+    std::vector<long> offsets;
+    std::vector<int>  sizes;
+    std::vector<int>  edges;
+
+    long used_edges = 0;
+};
+
+SolutionStore::SolutionStore( int num_nets )
+: offsets( num_nets, 0 ), sizes( num_nets, 0 )
+{
+    assert( num_nets >= 0 );
+}
+
+std::span<const int> SolutionStore::edges_of( int net_index ) const
+{
+    assert( 0 <= net_index && net_index < count_nets() );
+    return std::span<const int>( edges.data() + offsets[net_index], sizes[net_index] );
+}
+
+void SolutionStore::assign( int net_index, std::span<const int> net_edges )
+{
+    assert( 0 <= net_index && net_index < count_nets() );
+
+    used_edges -= sizes[net_index];
+
+    offsets[net_index] = edges.size();
+    sizes[net_index]   = net_edges.size();
+    edges.insert( edges.end(), net_edges.begin(), net_edges.end() );
+
+    used_edges += sizes[net_index];
+
+    if( edges.size() > 2 * used_edges + 1024 ) compact();
+}
+
+void SolutionStore::compact()
+{
+    std::vector<int> compacted;
+    compacted.reserve( used_edges );
+
+    for( int n = 0; n < count_nets(); n++ )
+    {
+        const auto net_edges = edges_of( n );
+        offsets[n] = compacted.size();
+        compacted.insert( compacted.end(), net_edges.begin(), net_edges.end() );
+    }
+
+    assert( compacted.size() == used_edges );
+
+    edges = std::move( compacted );
+}
+
+std::size_t SolutionStore::memory_bytes() const
+{
+    return offsets.capacity() * sizeof(long) + sizes.capacity() * sizeof(int) + edges.capacity() * sizeof(int);
+}
+
+std::size_t SolutionStore::memory_bytes_as_sets() const
+{
+    return count_nets() * sizeof(std::set<int>) + used_edges * 48;
+}
+
+
+
+// Set of indices below a fixed bound that is cleared in constant time. 
+// An index is in the set if its stamp equals the current generation. 
+// The members are listed in the order of insertion. 
+
+class StampedIndexSet
+{
+  public:
+
+    void resize( int bound ) { stamps.assign( bound, 0 ); generation = 1; members.clear(); }
+
+    int bound() const { return stamps.size(); }
+
+    void clear()
+    {
+        members.clear();
+        generation++;
+        // after the counter wraps around, all stamps are reset once 
+        if( generation == 0 ) { stamps.assign( stamps.size(), 0 ); generation = 1; }
+    }
+
+    bool contains( int index ) const
+    {
+        assert( 0 <= index && index < bound() );
+        return stamps[index] == generation;
+    }
+
+    // returns whether the index was new 
+    bool insert( int index )
+    {
+        if( contains( index ) ) return false;
+        stamps[index] = generation;
+        members.push_back( index );
+        return true;
+    }
+
+    const std::vector<int>& get_members() const { return members; }
+
+  private:
+
+    std::vector<unsigned int> stamps;
+    unsigned int              generation = 1;
+    std::vector<int>          members;
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef IG_STEINER
+#define IG_STEINER
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+// Topology of a net in the plane: 
+// an approximation of the rectilinear Steiner minimal tree of the pins. 
+// 
+// - For three points, the median point is the only Steiner point needed. 
+// - For up to `max_steiner_degree` points, the iterated 1-Steiner heuristic adds the point of the Hanan grid 
+//   that reduces the length of the minimum spanning tree most, until no point helps anymore. 
+// - For more points, the minimum spanning tree is used. 
+
+typedef std::pair<int,int> PlanarPoint;
+
+int rectilinear_distance( const PlanarPoint& p, const PlanarPoint& q );
+
+// Minimum spanning tree with rectilinear distances (Prim), as pairs of indices into `points` 
+std::vector<std::pair<int,int>> rectilinear_spanning_tree( const std::vector<PlanarPoint>& points );
+
+int tree_length( const std::vector<PlanarPoint>& points, const std::vector<std::pair<int,int>>& tree );
+
+// Appends the Steiner points to `points` and returns the edges of the tree, as pairs of indices into `points`. 
+// The input points must be distinct. 
+std::vector<std::pair<int,int>> rectilinear_steiner_tree( std::vector<PlanarPoint>& points, int max_steiner_degree = 8 );
+
+
+
+int rectilinear_distance( const PlanarPoint& p, const PlanarPoint& q )
+{
+    return std::abs( p.first - q.first ) + std::abs( p.second - q.second );
+}
+
+std::vector<std::pair<int,int>> rectilinear_spanning_tree( const std::vector<PlanarPoint>& points )
+{
+    const int n = points.size();
+
+    std::vector<std::pair<int,int>> ret;
+    
+    if( n <= 1 ) return ret;
+
+    ret.reserve( n - 1 );
+
+    // distance of each point to the tree, and the nearest point in the tree 
+    std::vector<int>  distance( n, std::numeric_limits<int>::max() );
+    std::vector<int>  nearest( n, -1 );
+    std::vector<bool> in_tree( n, false );
+
+    int current = 0;
+    in_tree[current] = true;
+
+    for( int k = 1; k < n; k++ )
+    {
+        int next = -1;
+
+        for( int i = 0; i < n; i++ )
+        {
+            if( in_tree[i] ) continue;
+
+            const int d = rectilinear_distance( points[current], points[i] );
+            if( d < distance[i] ) { distance[i] = d; nearest[i] = current; }
+
+            if( next == -1 or distance[i] < distance[next] ) next = i;
+        }
+
+        assert( next != -1 and nearest[next] != -1 );
+
+        in_tree[next] = true;
+        ret.push_back( { nearest[next], next } );
+        current = next;
+    }
+
+    assert( ret.size() == n - 1 );
+    return ret;
+}
+
+int tree_length( const std::vector<PlanarPoint>& points, const std::vector<std::pair<int,int>>& tree )
+{
+    int ret = 0;
+    for( const auto& edge : tree ) ret += rectilinear_distance( points[edge.first], points[edge.second] );
+    return ret;
+}
+
+std::vector<std::pair<int,int>> rectilinear_steiner_tree( std::vector<PlanarPoint>& points, int max_steiner_degree )
+{
+    const int num_pins = points.size();
+
+    // the median point is a Steiner point of an optimal tree for three pins 
+
+    if( num_pins == 3 )
+    {
+        std::vector<int> xs = { points[0].first,  points[1].first,  points[2].first  };
+        std::vector<int> ys = { points[0].second, points[1].second, points[2].second };
+        std::sort( xs.begin(), xs.end() );
+        std::sort( ys.begin(), ys.end() );
+
+        const PlanarPoint median = { xs[1], ys[1] };
+
+        for( int i = 0; i < 3; i++ ) 
+        if( points[i] == median ) 
+            return rectilinear_spanning_tree( points );
+
+        points.push_back( median );
+        return { { 0, 3 }, { 1, 3 }, { 2, 3 } };
+    }
+
+    if( num_pins < 3 or num_pins > max_steiner_degree ) return rectilinear_spanning_tree( points );
+
+    // iterated 1-Steiner on the Hanan grid 
+
+    std::vector<int> xs, ys;
+    for( const auto& p : points ) { xs.push_back( p.first ); ys.push_back( p.second ); }
+    std::sort( xs.begin(), xs.end() ); xs.erase( std::unique( xs.begin(), xs.end() ), xs.end() );
+    std::sort( ys.begin(), ys.end() ); ys.erase( std::unique( ys.begin(), ys.end() ), ys.end() );
+
+    auto tree = rectilinear_spanning_tree( points );
+    int length = tree_length( points, tree );
+
+    while( true )
+    {
+        PlanarPoint best_point;
+        int best_length = length;
+
+        for( const int x : xs )
+        for( const int y : ys )
+        {
+            const PlanarPoint candidate = { x, y };
+            if( std::find( points.begin(), points.end(), candidate ) != points.end() ) continue;
+
+            points.push_back( candidate );
+            const int candidate_length = tree_length( points, rectilinear_spanning_tree( points ) );
+            points.pop_back();
+
+            if( candidate_length < best_length ) { best_length = candidate_length; best_point = candidate; }
+        }
+
+        if( best_length == length ) break;
+
+        points.push_back( best_point );
+        tree   = rectilinear_spanning_tree( points );
+        length = best_length;
+
+        // Steiner points with at most two neighbors are not needed: 
+        // by the triangle inequality, the neighbors can be connected directly 
+
+        bool removed = true;
+        while( removed )
+        {
+            removed = false;
+
+            std::vector<int> degree( points.size(), 0 );
+            for( const auto& edge : tree ) { degree[edge.first]++; degree[edge.second]++; }
+
+            for( int i = num_pins; i < points.size(); i++ )
+            {
+                if( degree[i] > 2 ) continue;
+                points.erase( points.begin() + i );
+                tree   = rectilinear_spanning_tree( points );
+                length = tree_length( points, tree );
+                removed = true;
+                break;
+            }
+        }
+    }
+
+    assert( tree.size() + 1 == points.size() );
+    return tree;
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef IG_TELEMETRY
+#define IG_TELEMETRY
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "grp.hpp"
+
+// Verbosity of the log, fixed at compile time, for instance with -DIG_LOG_LEVEL=2. 
+// Messages above the level are discarded by `if constexpr` and cost nothing. 
+// 
+//  0: no statistics 
+//  1: summaries of the phases, and of the routing of all nets 
+//  2: also a message for every net and every search 
+
+#ifndef IG_LOG_LEVEL
+#define IG_LOG_LEVEL 1
+#endif
+
+constexpr int log_level_quiet   = 0;
+constexpr int log_level_summary = 1;
+constexpr int log_level_search  = 2;
+
+constexpr int log_level = IG_LOG_LEVEL;
+
+
+
+// Counters of the routing of one net. 
+// The searches update the counters in their workspace, and the router adds them to the record of the net. 
+
+struct NetRecord
+{
+    // how often the net was routed, including retries and rerouting 
+    int  routings    = 0;
+    long expansions  = 0;
+    int  peak_queue  = 0;
+    // nodes of the largest box that was searched 
+    long box_nodes   = 0;
+    bool emergency   = false;
+    long nanoseconds = 0;
+};
+
+
+
+// Records of all nets, allocated once, so that routing a net only updates its own record. 
+// At the end, the records are summarized with a histogram of the routing times, or written to a CSV file. 
+
+class Telemetry
+{
+  public:
+
+    explicit Telemetry( int num_nets = 0 ) : records( num_nets ) {}
+
+    int count_nets() const { return records.size(); }
+
+    const NetRecord& operator[]( int net_index ) const { return records[net_index]; }
+
+    // Adds the counters of one routing of a net. Only one thread may route a net at a time. 
+    void record( int net_index, const NetRecord& counters );
+
+    void log_summary( std::ostream& os ) const;
+
+    bool write_csv( const std::string& filename, const GlobalRoutingProblem& problem ) const;
+
+    // the routing times are counted in buckets of powers of two microseconds 
+    static const int histogram_buckets;
+
+  private:
+
+    std::vector<NetRecord> records;
+};
+
+const int Telemetry::histogram_buckets = 24;
+
+void Telemetry::record( int net_index, const NetRecord& counters )
+{
+    assert( 0 <= net_index && net_index < records.size() );
+
+    auto& record = records[net_index];
+
+    record.routings    += 1;
+    record.expansions  += counters.expansions;
+    record.peak_queue   = std::max( record.peak_queue, counters.peak_queue );
+    record.box_nodes    = std::max( record.box_nodes, counters.box_nodes );
+    record.emergency    = record.emergency or counters.emergency;
+    record.nanoseconds += counters.nanoseconds;
+}
+
+void Telemetry::log_summary( std::ostream& os ) const
+{
+    std::vector<long> nanoseconds;
+    long routings = 0, expansions = 0, emergency_nets = 0, total_nanoseconds = 0;
+
+    for( const auto& record : records ) {
+        if( record.routings == 0 ) continue;
+        nanoseconds.push_back( record.nanoseconds );
+        routings          += record.routings;
+        expansions        += record.expansions;
+        emergency_nets    += record.emergency;
+        total_nanoseconds += record.nanoseconds;
+    }
+
+    if( nanoseconds.empty() ) return;
+
+    std::sort( nanoseconds.begin(), nanoseconds.end() );
+
+    const auto percentile = [&]( double p ) -> double { return 1e-3 * nanoseconds[ std::min<std::size_t>( nanoseconds.size() - 1, p * nanoseconds.size() ) ]; };
+
+    os << "Net telemetry: " << nanoseconds.size() << " nets routed " << routings << " times" 
+       << "\t expansions: " << expansions << "\t emergency nets: " << emergency_nets << "\t time: " << 1e-9 * total_nanoseconds << "s" << nl;
+
+    os << "Routing time per net: p50 " << percentile( 0.5 ) << "us\t p90 " << percentile( 0.9 ) << "us\t p99 " << percentile( 0.99 ) 
+       << "us\t p99.9 " << percentile( 0.999 ) << "us\t max " << 1e-3 * nanoseconds.back() << "us" << nl;
+
+    // bucket b holds the times below 2^b microseconds, and at least 2^(b-1) microseconds 
+    std::vector<int> histogram( histogram_buckets, 0 );
+    for( const long ns : nanoseconds ) {
+        int b = 0;
+        while( b + 1 < histogram_buckets and ns >= ( 1000L << b ) ) b++;
+        histogram[b]++;
+    }
+
+    for( int b = 0; b < histogram_buckets; b++ ) {
+        if( histogram[b] == 0 ) continue;
+        os << "  < " << ( 1L << b ) << "us: " << histogram[b] << tab << std::string( ( 60L * histogram[b] + nanoseconds.size() - 1 ) / nanoseconds.size(), '#' ) << nl;
+    }
+}
+
+bool Telemetry::write_csv( const std::string& filename, const GlobalRoutingProblem& problem ) const
+{
+    assert( problem.nets.size() == records.size() );
+
+    std::string buffer = "net,name,pins,routings,expansions,peak_queue,box_nodes,emergency,nanoseconds\n";
+    buffer.reserve( buffer.size() + 80 * records.size() );
+
+    char text[24];
+    const auto append = [&]( long value, char separator ) -> void {
+        buffer.append( text, std::to_chars( text, text + sizeof(text), value ).ptr );
+        buffer += separator;
+    };
+
+    for( int n = 0; n < records.size(); n++ )
+    {
+        const auto& record = records[n];
+        append( problem.nets[n].id, ',' );
+        buffer += problem.nets[n].name;
+        buffer += ',';
+        append( problem.nets[n].pins.size(), ',' );
+        append( record.routings,    ',' );
+        append( record.expansions,  ',' );
+        append( record.peak_queue,  ',' );
+        append( record.box_nodes,   ',' );
+        append( record.emergency,   ',' );
+        append( record.nanoseconds, '\n' );
+    }
+
+    std::ofstream file( filename, std::ios::binary );
+    file.write( buffer.data(), buffer.size() );
+    return file.good();
+}
+
+#endif
@@ -0,0 +1,484 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+#include "connector.hpp"
+#include "evaluator.hpp"
+#include "graph.hpp"
+#include "grp.hpp"
+#include "grp2graph.hpp"
+#include "output_tree.hpp"
+
+// A small and congested instance: 
+// the layers alternate between horizontal and vertical capacity, 
+// and there are many nets, so that some nets need the emergency mode 
+
+GlobalRoutingProblem create_test_problem( int seed )
+{
+    std::mt19937 generator( seed );
+
+    GlobalRoutingProblem problem;
+
+    problem.grid = { 24, 24, 4 };
+
+    problem.capacity.horizontal = { 8, 0, 8, 0 };
+    problem.capacity.vertical   = { 0, 8, 0, 8 };
+
+    problem.dimension.minimum_width   = { 1, 1, 1, 1 };
+    problem.dimension.minimum_spacing = { 1, 1, 1, 1 };
+    problem.dimension.via_spacing     = { 1, 1, 1, 1 };
+
+    problem.tileInfo = { 0, 0, 10, 10 };
+
+    const int num_nets = 400;
+
+    for( int n = 0; n < num_nets; n++ )
+    {
+        Net net;
+        net.name          = "n" + std::to_string( n );
+        net.id            = n;
+        net.num_pins      = 2 + generator() % 4;
+        net.minimum_width = 1 + generator() % 2;
+
+        const int center_x = generator() % 240;
+        const int center_y = generator() % 240;
+        const int radius   = 5 + generator() % 80;
+
+        for( int p = 0; p < net.num_pins; p++ )
+        {
+            Pin pin;
+            pin.x     = std::clamp<int>( center_x + generator() % ( 2 * radius + 1 ) - radius, 0, 239 );
+            pin.y     = std::clamp<int>( center_y + generator() % ( 2 * radius + 1 ) - radius, 0, 239 );
+            pin.layer = 0;
+            net.pins.push_back( pin );
+        }
+
+        problem.nets.push_back( net );
+    }
+
+    for( int a = 0; a < 20; a++ )
+    {
+        const int x = 4 * a % 23;
+        const int y = 7 * a % 24;
+        problem.capacityAdjustments.push_back( { x, y, 0, x + 1, y, 0, 2 } );
+    }
+
+    assert( problem.check() );
+
+    return problem;
+}
+
+std::size_t solution_hash( GlobalRoutingProblem& problem, Graph& graph, RoutingOptions options )
+{
+    Connector connector( problem, graph, options );
+
+    const auto trees = connector.connect();
+
+    std::ostringstream output;
+    for( int n = 0; n < problem.nets.size(); n++ ) {
+        output_tree_for_net( output, problem, graph, n, trees.edges_of( n ) );
+    }
+
+    return std::hash<std::string>()( output.str() );
+}
+
+int main()
+{
+    GlobalRoutingProblem problem = create_test_problem( 42 );
+
+    problem.heuristic_optimization();
+
+    Graph graph = createGraphFromGlobalRoutingProblem( problem );
+
+    // The deterministic mode must produce the same solution for any number of threads 
+    {
+        RoutingOptions options;
+        options.deterministic = true;
+
+        options.num_threads = 1;
+        const auto reference_hash = solution_hash( problem, graph, options );
+
+        for( int num_threads : { 1, 2, 3, 4, 8 } )
+        {
+            options.num_threads = num_threads;
+            const auto hash = solution_hash( problem, graph, options );
+            std::clog << "Deterministic mode, threads: " << num_threads << "\t hash: " << hash << nl;
+            assert( hash == reference_hash );
+        }
+    }
+
+    // The buffered writer must produce the same file as the stream output, with any number of threads 
+    {
+        Connector connector( problem, graph );
+
+        const auto trees = connector.connect();
+
+        std::ostringstream expected;
+        for( int n = 0; n < problem.nets.size(); n++ ) output_tree_for_net( expected, problem, graph, n, trees.edges_of( n ) );
+
+        const SolutionWriter writer( problem, graph );
+
+        auto scratch = writer.create_scratch();
+
+        std::string formatted;
+        for( int n = 0; n < problem.nets.size(); n++ ) {
+            const auto previous_size = formatted.size();
+            writer.format_net( scratch, formatted, n, trees.edges_of( n ) );
+            assert( formatted.size() - previous_size == writer.count_net_bytes( scratch, n, trees.edges_of( n ) ) );
+        }
+        assert( formatted == expected.str() );
+
+        for( const int num_threads : { 1, 3, 8 } )
+        {
+            const std::string filename = "test_connector.solution.tmp";
+            assert( writer.write( filename, trees, num_threads ) );
+
+            std::ifstream file( filename, std::ios::binary );
+            std::ostringstream written;
+            written << file.rdbuf();
+            file.close();
+            std::remove( filename.c_str() );
+
+            assert( written.str() == expected.str() );
+        }
+    }
+
+    // The merged segments must cover exactly the edges of each tree, and the merged file must not depend on the threads 
+    {
+        Connector connector( problem, graph );
+
+        const auto trees = connector.connect();
+
+        const auto layout = graph.get_layout();
+
+        const SolutionWriter writer( problem, graph, true );
+
+        auto scratch = writer.create_scratch();
+
+        std::string formatted;
+        int count_lines = 0;
+
+        for( int n = 0; n < problem.nets.size(); n++ )
+        {
+            std::vector<int> covered;
+
+            writer.collect_segments( scratch, n, trees.edges_of( n ) );
+
+            for( const auto& [ x, y, z, dx, dy, dz, length ] : scratch.segments ) {
+                assert( length >= 1 );
+                for( int i = 0; i < length; i++ ) {
+                    const int cx = x + i * dx, cy = y + i * dy, cz = z + i * dz;
+                    covered.push_back( dx ? layout.x_edge( cx, cy, cz ) : dy ? layout.y_edge( cx, cy, cz ) : layout.z_edge( cx, cy, cz ) );
+                }
+                count_lines++;
+            }
+
+            std::sort( covered.begin(), covered.end() );
+            assert( std::ranges::equal( covered, trees.edges_of( n ) ) );
+
+            const auto previous_size = formatted.size();
+            writer.format_net( scratch, formatted, n, trees.edges_of( n ) );
+            assert( formatted.size() - previous_size == writer.count_net_bytes( scratch, n, trees.edges_of( n ) ) );
+        }
+
+        assert( count_lines < trees.count_edges() );
+
+        std::clog << "Merged segments: " << count_lines << " lines for " << trees.count_edges() << " edges\n";
+
+        for( const int num_threads : { 1, 3 } )
+        {
+            const std::string filename = "test_connector.solution.tmp";
+            assert( writer.write( filename, trees, num_threads ) );
+
+            std::ifstream file( filename, std::ios::binary );
+            std::ostringstream written;
+            written << file.rdbuf();
+            file.close();
+            std::remove( filename.c_str() );
+
+            assert( written.str() == formatted );
+        }
+    }
+
+    // The evaluator must recompute the usage of the router from the trees, 
+    // and score the solution files with unit edges and with merged segments like the trees themselves 
+    {
+        Connector connector( problem, graph );
+
+        auto trees = connector.connect();
+        connector.negotiate( trees );
+
+        const Evaluator evaluator( problem, graph, 3 );
+
+        const auto usage = evaluator.compute_usage( trees );
+        assert( usage == connector.get_aggregated_width() );
+
+        const auto evaluation = evaluator.evaluate( usage, trees );
+        std::clog << evaluation << nl;
+
+        assert( evaluation.wirelength + evaluation.vias == trees.count_edges() );
+        assert( evaluation.total_wirelength() == evaluation.wirelength + 3 * evaluation.vias );
+        assert( evaluation.max_overflow <= evaluation.total_overflow );
+        assert( ( evaluation.overflowed_edges > 0 ) == ( evaluation.total_overflow > 0 ) );
+
+        // overflows of 3 and 5 units are 2 and 3 tracks of width 1 and spacing 1 
+        std::vector<int> excessive_usage( graph.count_edges(), 0 );
+        const auto layout = graph.get_layout();
+        excessive_usage[ layout.x_edge( 3, 3, 0 ) ] = graph.get_capacity( layout.x_edge( 3, 3, 0 ) ) + 3;
+        excessive_usage[ layout.y_edge( 5, 2, 1 ) ] = graph.get_capacity( layout.y_edge( 5, 2, 1 ) ) + 5;
+
+        const auto excessive_evaluation = evaluator.evaluate( excessive_usage, SolutionStore( problem.nets.size() ) );
+        assert( excessive_evaluation.total_overflow == 5 );
+        assert( excessive_evaluation.max_overflow == 3 );
+        assert( excessive_evaluation.overflowed_edges == 2 );
+        assert( excessive_evaluation.total_wirelength() == 0 );
+
+        for( const bool merge_segments : { false, true } )
+        {
+            const std::string filename = "test_connector.solution.tmp";
+
+            const SolutionWriter writer( problem, graph, merge_segments );
+            assert( writer.write( filename, trees ) );
+
+            SolutionStore read_trees;
+            assert( evaluator.read_solution( filename, read_trees ) );
+            std::remove( filename.c_str() );
+
+            for( int n = 0; n < problem.nets.size(); n++ ) {
+                assert( std::ranges::equal( read_trees.edges_of( n ), trees.edges_of( n ) ) );
+            }
+
+            const auto read_evaluation = evaluator.evaluate( read_trees );
+            assert( read_evaluation.total_overflow == evaluation.total_overflow );
+            assert( read_evaluation.max_overflow   == evaluation.max_overflow );
+            assert( read_evaluation.total_wirelength() == evaluation.total_wirelength() );
+        }
+    }
+
+    // The stride-based search kernel must produce the same solution as the reference kernel, 
+    // on stacked layers, on the projected grid with a single layer, and within coarse corridors 
+    for( int mode = 0; mode < 3; mode++ )
+    {
+        RoutingOptions options;
+        options.deterministic = true;
+        if( mode == 1 ) options.projected        = true;
+        if( mode == 2 ) options.coarse_tile_size = 4;
+
+        options.reference_kernel = true;
+        const auto reference_hash = solution_hash( problem, graph, options );
+
+        options.reference_kernel = false;
+        const auto hash = solution_hash( problem, graph, options );
+
+        std::clog << "Search kernels, mode: " << mode << "\t hash: " << hash << "\t reference: " << reference_hash << nl;
+        assert( hash == reference_hash );
+    }
+
+    // The compact labels of small boxes must lead to the same solution as the labels of the whole graph 
+    for( int mode = 0; mode < 2; mode++ )
+    {
+        RoutingOptions options;
+        options.deterministic = true;
+        if( mode == 1 ) options.projected = true;
+
+        options.local_search_nodes = 0;
+        const auto reference_hash = solution_hash( problem, graph, options );
+
+        for( int local_search_nodes : { 64, 1 << 15 } )
+        {
+            options.local_search_nodes = local_search_nodes;
+            const auto hash = solution_hash( problem, graph, options );
+            std::clog << "Local labels, mode: " << mode << "\t nodes: " << local_search_nodes << "\t hash: " << hash << "\t reference: " << reference_hash << nl;
+            assert( hash == reference_hash );
+        }
+    }
+
+    // The capacity audit must agree with the evaluator for any number of threads, and must notice usage without trees 
+    for( const int num_threads : { 1, 4 } )
+    {
+        RoutingOptions options;
+        options.num_threads = num_threads;
+
+        Connector connector( problem, graph, options );
+
+        auto trees = connector.connect();
+
+        const auto audit = connector.audit_capacities( trees );
+        assert( audit.mismatched_edges == 0 );
+        assert( std::is_sorted( audit.overflowed_edges.begin(), audit.overflowed_edges.end() ) );
+        assert( std::is_sorted( audit.overflowed_nets.begin(), audit.overflowed_nets.end() ) );
+
+        const Evaluator evaluator( problem, graph );
+        assert( audit.overflowed_edges.size() == evaluator.evaluate( trees ).overflowed_edges );
+
+        for( const int n : audit.overflowed_nets ) {
+            const auto tree = trees.edges_of( n );
+            assert( std::ranges::any_of( tree, [&]( int e ) -> bool { return std::ranges::binary_search( audit.overflowed_edges, e ); } ) );
+        }
+
+        std::clog << "Capacity audit, threads: " << num_threads << "\t overflowed edges: " << audit.overflowed_edges.size() << "\t nets: " << audit.overflowed_nets.size() << nl;
+
+        // forget the tree of a net with planar edges, while its usage remains 
+        const auto layout = graph.get_layout();
+        int n = 0;
+        while( trees.edges_of( n ).empty() or trees.edges_of( n ).front() >= layout.z_edges_offset ) n++;
+
+        const auto planar_edges = std::ranges::count_if( trees.edges_of( n ), [&]( int e ) -> bool { return e < layout.z_edges_offset; } );
+        trees.assign( n, std::vector<int>() );
+        assert( connector.audit_capacities( trees ).mismatched_edges == planar_edges );
+    }
+
+    // Every routed net must have a record in the telemetry, which is written as one line per net 
+    {
+        Connector connector( problem, graph );
+
+        auto trees = connector.connect();
+        connector.negotiate( trees );
+
+        const auto& telemetry = connector.get_telemetry();
+        assert( telemetry.count_nets() == problem.nets.size() );
+
+        for( int n = 0; n < problem.nets.size(); n++ ) {
+            const auto& record = telemetry[n];
+            assert( ( record.routings > 0 ) == ( problem.nets[n].pins.size() > 0 ) );
+            assert( record.expansions >= 0 and record.nanoseconds >= 0 );
+            if( record.expansions > 0 ) assert( record.peak_queue > 0 and record.box_nodes > 0 );
+        }
+
+        telemetry.log_summary( std::clog );
+
+        const std::string filename = "test_connector.telemetry.tmp";
+        assert( telemetry.write_csv( filename, problem ) );
+
+        std::ifstream file( filename );
+        std::string line;
+        int count_lines = 0;
+        while( std::getline( file, line ) ) count_lines++;
+        file.close();
+        std::remove( filename.c_str() );
+
+        assert( count_lines == problem.nets.size() + 1 );
+    }
+
+    // The tree checker must reject cycles, disconnected edges, missing targets, and leaves that are not targets 
+    {
+        const auto layout = graph.get_layout();
+        const auto node   = [&]( int x, int y, int z ) -> int { return graph.get_nodeindex_from_position( x, y, z ); };
+        const auto sorted = []( std::vector<int> edges ) -> std::vector<int> { std::sort( edges.begin(), edges.end() ); return edges; };
+
+        TreeChecker checker;
+
+        const std::vector<int> targets = { node( 0, 0, 0 ), node( 2, 0, 0 ) };
+
+        assert( checker.check( graph, targets, sorted( { layout.x_edge( 0, 0, 0 ), layout.x_edge( 1, 0, 0 ) } ) ).empty() );
+        assert( checker.check( graph, targets, sorted( { layout.x_edge( 0, 0, 0 ), layout.x_edge( 1, 0, 0 ), layout.y_edge( 1, 0, 0 ) } ) ) == "leaf that is not a target" );
+        assert( checker.check( graph, targets, sorted( { layout.x_edge( 0, 0, 0 ) } ) ) == "target not on the tree" );
+        assert( checker.check( graph, targets, sorted( { layout.x_edge( 0, 0, 0 ), layout.x_edge( 5, 5, 0 ) } ) ) == "not connected" );
+        assert( checker.check( graph, targets, sorted( { layout.x_edge( 0, 0, 0 ), layout.y_edge( 1, 0, 0 ), layout.x_edge( 0, 1, 0 ), layout.y_edge( 0, 0, 0 ) } ) ) == "cycle" );
+        assert( checker.check( graph, std::vector<int>{ node( 3, 3, 0 ), node( 3, 3, 2 ) }, {} ).empty() );
+        assert( checker.check( graph, targets, {} ) == "targets on different tiles without edges" );
+    }
+
+    // The routing on the projected grid and the routing within coarse corridors must lead to a valid tree for every net 
+    for( int mode = 0; mode < 2; mode++ )
+    {
+        RoutingOptions options;
+        if( mode == 0 ) options.projected        = true;
+        if( mode == 1 ) options.coarse_tile_size = 4;
+
+        Connector connector( problem, graph, options );
+
+        const auto trees = connector.connect();
+
+        for( int n = 0; n < problem.nets.size(); n++ ) {
+            std::vector<int> targets;
+            for( const auto& pin : problem.nets[n].pins ) {
+                const auto tile_xy = problem.tile_of_coordinate( pin.x, pin.y );
+                targets.push_back( graph.get_nodeindex_from_position( tile_xy.first, tile_xy.second, pin.layer ) );
+            }
+            assert( connector.verify_connector( n, targets, trees.edges_of( n ) ) );
+        }
+
+        assert( connector.count_invalid_trees( trees ) == 0 );
+    }
+
+    // A coarse corridor that leaves the largest search box must not stop the emergency search: 
+    // a wall without capacity separates the pins up to row 120, so the coarse route passes above it, 
+    // outside the box, whose margin is capped at 80 tiles above the pins in row 8 
+    {
+        GlobalRoutingProblem walled;
+
+        walled.grid = { 240, 200, 1 };
+
+        walled.capacity.horizontal = { 20 };
+        walled.capacity.vertical   = { 20 };
+
+        walled.dimension.minimum_width   = { 1 };
+        walled.dimension.minimum_spacing = { 1 };
+        walled.dimension.via_spacing     = { 1 };
+
+        walled.tileInfo = { 0, 0, 10, 10 };
+
+        Net net;
+        net.name          = "walled";
+        net.id            = 0;
+        net.num_pins      = 2;
+        net.minimum_width = 1;
+        net.pins          = { { 405, 85, 0 }, { 2005, 85, 0 } };
+        walled.nets.push_back( net );
+
+        for( int x = 64; x < 176; x++ )
+            for( int y = 0; y < 120; y++ ) 
+                walled.capacityAdjustments.push_back( { x, y, 0, x + 1, y, 0, 0 } );
+
+        assert( walled.check() );
+
+        Graph walled_graph = createGraphFromGlobalRoutingProblem( walled );
+
+        RoutingOptions options;
+        options.coarse_tile_size = 16;
+        options.pattern_routing  = false;
+
+        Connector connector( walled, walled_graph, options );
+
+        const auto trees = connector.connect();
+
+        assert( connector.count_invalid_trees( trees ) == 0 );
+
+        // the tree stays within the box and crosses the wall 
+        bool crosses_wall = false;
+        for( const int e : trees.edges_of( 0 ) ) {
+            const auto [ x1, y1, z1 ] = walled_graph.get_position_from_nodeindex( walled_graph.get_nodes_of_edge( e ).first );
+            const auto [ x2, y2, z2 ] = walled_graph.get_position_from_nodeindex( walled_graph.get_nodes_of_edge( e ).second );
+            assert( std::max( y1, y2 ) <= 88 );
+            if( std::min( x1, x2 ) == 100 and std::max( x1, x2 ) == 101 ) crosses_wall = true;
+        }
+        assert( crosses_wall );
+        assert( connector.get_telemetry()[0].emergency );
+    }
+
+    std::clog << "Succeeded. \n";
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cassert>
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+#include "generator.hpp"
+#include "graph.hpp"
+#include "grp.hpp"
+#include "grp2graph.hpp"
+
+std::string as_text( const GlobalRoutingProblem& problem )
+{
+    std::ostringstream os;
+    problem.write( os );
+    return os.str();
+}
+
+int main()
+{
+    GeneratorParameters parameters;
+    parameters.x_grids            = 40;
+    parameters.y_grids            = 30;
+    parameters.layers             = 4;
+    parameters.num_nets           = 2000;
+    parameters.clusters           = 3;
+    parameters.adjustment_density = 0.05;
+    parameters.wide_net_fraction  = 0.1;
+
+    // The same seed gives the same instance, and another seed a different one 
+    const GlobalRoutingProblem problem = ProblemGenerator( parameters ).generate();
+    {
+        assert( as_text( problem ) == as_text( ProblemGenerator( parameters ).generate() ) );
+
+        ProblemGenerator generator( parameters );
+        generator.generate();
+        assert( as_text( problem ) == as_text( generator.generate() ) );
+
+        GeneratorParameters other = parameters;
+        other.seed++;
+        assert( as_text( problem ) != as_text( ProblemGenerator( other ).generate() ) );
+    }
+
+    // The instance is valid, and reading its file gives the same instance 
+    {
+        assert( problem.check() );
+        assert( problem.nets.size() == parameters.num_nets );
+
+        std::istringstream is( as_text( problem ) );
+        GlobalRoutingProblem read_problem;
+        read_problem.read( is );
+        assert( read_problem.check() );
+        assert( as_text( read_problem ) == as_text( problem ) );
+
+        const Graph graph = createGraphFromGlobalRoutingProblem( problem );
+        assert( graph.count_edges() > 0 );
+    }
+
+    // The pin counts follow the power law, two-pin nets dominate, and the pins of small nets are on distinct tiles 
+    {
+        int two_pin_nets = 0, wide_nets = 0;
+
+        for( const auto& net : problem.nets ) {
+            assert( 2 <= net.num_pins and net.num_pins <= parameters.max_pins );
+            if( net.num_pins == 2 ) two_pin_nets++;
+            if( net.minimum_width == 2 ) wide_nets++;
+
+            std::set<std::pair<int,int>> tiles;
+            for( const auto& pin : net.pins ) {
+                assert( pin.layer == 0 );
+                tiles.insert( problem.tile_of_coordinate( pin.x, pin.y ) );
+            }
+            if( net.num_pins <= 4 ) assert( tiles.size() == net.num_pins );
+        }
+
+        // P(2) = 1 / ( 1 + 1/4 + 1/9 + ... ) is about 0.63 
+        assert( 0.55 * parameters.num_nets < two_pin_nets and two_pin_nets < 0.70 * parameters.num_nets );
+        assert( 0.05 * parameters.num_nets < wide_nets and wide_nets < 0.15 * parameters.num_nets );
+    }
+
+    // The capacity adjustments reduce the capacity of planar edges along the routing direction of their layer 
+    {
+        long planar_edges = 0;
+        for( int z = 0; z < parameters.layers; z++ ) {
+            if( problem.capacity.horizontal[z] > 0 ) planar_edges += ( parameters.x_grids - 1 ) * parameters.y_grids;
+            if( problem.capacity.vertical[z]   > 0 ) planar_edges += parameters.x_grids * ( parameters.y_grids - 1 );
+        }
+
+        const long adjustments = problem.capacityAdjustments.size();
+        assert( 0.03 * planar_edges < adjustments and adjustments < 0.07 * planar_edges );
+
+        for( const auto& adjustment : problem.capacityAdjustments ) {
+            const int z = adjustment.layer_start;
+            assert( adjustment.layer_end == z );
+            if( adjustment.col_end == adjustment.col_start + 1 ) {
+                assert( adjustment.row_end == adjustment.row_start );
+                assert( adjustment.adjusted_capacity <= problem.capacity.horizontal[z] );
+            } else {
+                assert( adjustment.col_end == adjustment.col_start and adjustment.row_end == adjustment.row_start + 1 );
+                assert( adjustment.adjusted_capacity <= problem.capacity.vertical[z] );
+            }
+        }
+    }
+
+    // Clustered net centers crowd more pins into fewer tiles than uniform ones 
+    {
+        auto count_pin_tiles = []( const GlobalRoutingProblem& instance ) {
+            std::set<std::pair<int,int>> tiles;
+            for( const auto& net : instance.nets )
+                for( const auto& pin : net.pins ) tiles.insert( instance.tile_of_coordinate( pin.x, pin.y ) );
+            return tiles.size();
+        };
+
+        GeneratorParameters clustered = parameters;
+        clustered.clusters       = 1;
+        clustered.cluster_spread = 2.;
+
+        GeneratorParameters uniform = parameters;
+        uniform.clusters = 0;
+
+        assert( count_pin_tiles( ProblemGenerator( clustered ).generate() ) < count_pin_tiles( ProblemGenerator( uniform ).generate() ) );
+    }
+
+    std::clog << "Finished." << nl;
+
+    return 0;
+}
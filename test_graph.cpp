@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <cassert>
 
+#include <algorithm>
 #include <iostream>
 #include <tuple>
 #include <utility>
@@ -117,6 +118,56 @@ int main() {
         }
         
     }
+
+
+    // directions that are not usable on a layer are skipped 
+    {
+        Graph graph( 4, 5, 3 );
+
+        graph.set_direction_usable( 0, Graph::direction::y_plus, false );
+        graph.set_direction_usable( 1, Graph::direction::x_plus, false );
+
+        for( int nodeindex = 0; nodeindex < graph.count_nodes(); nodeindex++ )
+        {
+            int x, y, z;
+            std::tie( x, y, z ) = graph.get_position_from_nodeindex( nodeindex );
+
+            const auto all_edges    = graph.get_edgeindices_from_node( nodeindex );
+            const auto usable_edges = graph.get_usable_edgeindices_from_node( nodeindex );
+
+            for( const auto e : usable_edges ) 
+            {
+                assert( std::find( all_edges.begin(), all_edges.end(), e ) != all_edges.end() );
+                assert( graph.is_direction_usable( z, graph.get_edge_direction( e ) ) );
+            }
+
+            int expected = 0;
+            for( const auto e : all_edges ) expected += graph.is_direction_usable( z, graph.get_edge_direction( e ) ) ? 1 : 0;
+            assert( usable_edges.size() == expected );
+        }
+    }
+
+    // the strides and edge offsets of the layout agree with the decoding functions 
+    for( int dim_x = 1; dim_x <= 4; dim_x++ )
+    for( int dim_y = 1; dim_y <= 4; dim_y++ )
+    for( int dim_z = 1; dim_z <= 3; dim_z++ )
+    {
+        Graph graph( dim_x, dim_y, dim_z );
+
+        const auto layout = graph.get_layout();
+
+        for( int nodeindex = 0; nodeindex < graph.count_nodes(); nodeindex++ )
+        {
+            int x, y, z;
+            std::tie( x, y, z ) = graph.get_position_from_nodeindex( nodeindex );
+
+            assert( nodeindex == x * layout.stride_x + y * layout.stride_y + z );
+
+            if( x < dim_x-1 ) assert( layout.x_edge( x, y, z ) == graph.get_edgeindex_from_node_and_direction( nodeindex, Graph::direction::x_plus ) );
+            if( y < dim_y-1 ) assert( layout.y_edge( x, y, z ) == graph.get_edgeindex_from_node_and_direction( nodeindex, Graph::direction::y_plus ) );
+            if( z < dim_z-1 ) assert( layout.z_edge( x, y, z ) == graph.get_edgeindex_from_node_and_direction( nodeindex, Graph::direction::z_plus ) );
+        }
+    }
     
     return 0;
 }
@@ -17,6 +17,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <map>
 #include <tuple>
 #include <cmath>
+#include <cassert>
 
 #include "common.hpp"
 
@@ -26,6 +27,41 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 int main() {
     
+    // A capacity adjustment that gives capacity to a direction without default capacity on its layer 
+    // must make that direction usable there, while the other layers keep their masks 
+    {
+        GlobalRoutingProblem problem;
+
+        problem.grid = { 8, 8, 2 };
+
+        problem.capacity.horizontal = { 4, 0 };
+        problem.capacity.vertical   = { 0, 4 };
+
+        problem.dimension.minimum_width   = { 1, 1 };
+        problem.dimension.minimum_spacing = { 1, 1 };
+        problem.dimension.via_spacing     = { 1, 1 };
+
+        problem.tileInfo = { 0, 0, 10, 10 };
+
+        {
+            const Graph graph = createGraphFromGlobalRoutingProblem( problem );
+            assert(     graph.is_direction_usable( 0, Graph::direction::x_plus ) );
+            assert( not graph.is_direction_usable( 0, Graph::direction::y_plus ) );
+            assert( not graph.is_direction_usable( 1, Graph::direction::x_plus ) );
+            assert(     graph.is_direction_usable( 1, Graph::direction::y_plus ) );
+        }
+
+        problem.capacityAdjustments.push_back( { 3, 4, 0, 3, 5, 0, 2 } );
+        assert( problem.check() );
+
+        {
+            const Graph graph = createGraphFromGlobalRoutingProblem( problem );
+            assert( graph.is_direction_usable( 0, Graph::direction::y_plus ) );
+            assert( graph.get_capacity( graph.get_layout().y_edge( 3, 4, 0 ) ) == 2 );
+            assert( not graph.is_direction_usable( 1, Graph::direction::x_plus ) );
+        }
+    }
+
     const std::string filename = "adaptec1.capo70.2d.35.50.90.gr";
     std::ifstream file( filename, std::ios_base::openmode::_S_in );
     if( !file) {
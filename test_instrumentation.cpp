@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cassert>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+#include "instrumentation.hpp"
+
+int main()
+{
+    // The replaced operator new counts every allocation and its size 
+    {
+        const long allocations_before = allocation_counters::allocations.load();
+        const long bytes_before       = allocation_counters::allocated_bytes.load();
+
+        auto pointer = std::make_unique<std::vector<int>>( 1000 );
+
+        assert( allocation_counters::allocations.load() - allocations_before == 2 );
+        assert( allocation_counters::allocated_bytes.load() - bytes_before >= 1000 * sizeof(int) );
+    }
+
+    // Over-aligned allocations are counted as well 
+    {
+        struct alignas( 256 ) Block { char data[300]; };
+
+        const long allocations_before = allocation_counters::allocations.load();
+
+        auto block = std::make_unique<Block>();
+        assert( reinterpret_cast<std::uintptr_t>( block.get() ) % 256 == 0 );
+
+        std::vector<Block> blocks( 3 );
+        assert( reinterpret_cast<std::uintptr_t>( blocks.data() ) % 256 == 0 );
+
+        assert( allocation_counters::allocations.load() - allocations_before == 2 );
+    }
+
+    // The memory status is available on Linux 
+    {
+        const auto [ rss, peak_rss ] = read_resident_memory();
+        assert( rss > 0 and peak_rss >= rss );
+    }
+
+    // The phases are recorded in order, and the allocations of each phase are attributed to that phase 
+    {
+        InstrumentationReport report;
+
+        {
+            ScopedPhase phase( report, "allocate" );
+            std::vector<std::unique_ptr<int>> pointers;
+            for( int i = 0; i < 100; i++ ) pointers.push_back( std::make_unique<int>( i ) );
+        }
+
+        report.begin_phase( "idle" );
+        report.end_phase();
+
+        const auto& phases = report.get_phases();
+        assert( phases.size() == 2 );
+        assert( phases[0].name == "allocate" and phases[1].name == "idle" );
+        assert( phases[0].allocations >= 100 );
+        assert( phases[1].allocations == 0 );
+        assert( phases[0].seconds >= 0. and phases[0].peak_rss_bytes > 0 );
+
+        report.add_value( "instance", "a \"quoted\" name" );
+        report.add_value( "total_overflow", 42 );
+
+        const std::string json = report.to_json();
+        assert( json.front() == '{' );
+        assert( json.find( "\"instance\": \"a \\\"quoted\\\" name\"" ) != std::string::npos );
+        assert( json.find( "\"total_overflow\": 42," ) != std::string::npos );
+        assert( json.find( "{ \"name\": \"allocate\"" ) != std::string::npos );
+        assert( json.find( "\"peak_rss_bytes\"" ) != std::string::npos );
+
+        std::clog << json;
+    }
+
+    std::clog << "Finished." << nl;
+
+    return 0;
+}
@@ -131,6 +131,62 @@ void testPriorityQueue() {
         assert( pq.empty() );
     }
 
+    for( int N = 1; N <= 20; N++ )
+    {
+        clog << "Removal testing with " << N << " entries\n";
+
+        PriorityQueue pq;
+
+        // Create a vector of entries with randomized priorities and sparse values
+        vector<Entry> entries;
+        for( int i = 0; i < N; ++i) {
+            Entry entry = {3*i, 0.1f * prioritytype( rand() % 100 ) }; // Random priority
+            entries.push_back(entry);
+        }
+
+        random_shuffle( entries.begin(), entries.end());
+
+        for( const auto& entry : entries) {
+            pq.push(entry.value, entry.priority);
+        }
+
+        // remove every other entry, and check the lookup of the remaining ones 
+        vector<Entry> remaining;
+        for( int i = 0; i < N; i++ ) {
+            if( i % 2 == 0 ) {
+                pq.remove( entries[i].value );
+            } else {
+                remaining.push_back( entries[i] );
+            }
+        }
+
+        for( int i = 0; i < N; i++ ) {
+            assert( pq.contains( entries[i].value ) == ( i % 2 == 1 ) );
+            if( i % 2 == 1 ) assert( pq.getPriority( entries[i].value ) == entries[i].priority );
+        }
+        assert( not pq.contains( 3*N+1 ) );
+
+        sort(remaining.begin(), remaining.end(), [](const Entry& a, const Entry& b) {
+            return a.priority < b.priority || ( a.priority == b.priority && a.value < b.value );
+        });
+
+        for( const auto& entry : remaining ) {
+            Entry popped = pq.pop();
+            assert(popped.value == entry.value);
+            assert(popped.priority == entry.priority);
+            assert( not pq.contains( entry.value ) );
+        }
+
+        assert( pq.empty() );
+
+        // the queue can be reused after clearing 
+        pq.push( 5, 1. );
+        pq.clear();
+        assert( not pq.contains( 5 ) );
+        pq.push( 5, 2. );
+        assert( pq.getPriority( 5 ) == 2. );
+    }
+
     clog << "Priority queue unit test passed!" << endl;
 }
 
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <cassert>
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "common.hpp"
+
+#include "solution_store.hpp"
+
+int main()
+{
+    std::mt19937 random_engine( 7 );
+
+    // Replacing the edges of nets many times must keep the edges of every net, 
+    // and the store must stay compact enough 
+    {
+        const int num_nets = 50;
+
+        SolutionStore store( num_nets );
+        std::vector<std::vector<int>> expected( num_nets );
+
+        for( int round = 0; round < 2000; round++ )
+        {
+            const int n = random_engine() % num_nets;
+
+            std::vector<int> edges( random_engine() % 20 );
+            for( auto& e : edges ) e = random_engine() % 1000;
+
+            store.assign( n, edges );
+            expected[n] = edges;
+
+            long total = 0;
+            for( const auto& net_edges : expected ) total += net_edges.size();
+            assert( store.count_edges() == total );
+        }
+
+        for( int n = 0; n < num_nets; n++ ) {
+            const auto edges = store.edges_of( n );
+            assert( std::vector<int>( edges.begin(), edges.end() ) == expected[n] );
+        }
+
+        const auto bytes_before = store.memory_bytes();
+        store.compact();
+        assert( store.memory_bytes() <= bytes_before );
+
+        for( int n = 0; n < num_nets; n++ ) {
+            const auto edges = store.edges_of( n );
+            assert( std::vector<int>( edges.begin(), edges.end() ) == expected[n] );
+        }
+
+        std::clog << "Solution store: " << store.count_edges() << " edges in " << store.memory_bytes() << " bytes, as sets " << store.memory_bytes_as_sets() << " bytes\n";
+    }
+
+    // The stamped set agrees with std::set across many generations 
+    {
+        StampedIndexSet stamped;
+        stamped.resize( 100 );
+
+        for( int generation = 0; generation < 500; generation++ )
+        {
+            stamped.clear();
+            std::set<int> expected;
+
+            for( int i = 0; i < 30; i++ ) {
+                const int index = random_engine() % 100;
+                assert( stamped.insert( index ) == not expected.contains( index ) );
+                expected.insert( index );
+            }
+
+            for( int index = 0; index < 100; index++ ) assert( stamped.contains( index ) == expected.contains( index ) );
+
+            assert( stamped.get_members().size() == expected.size() );
+        }
+    }
+
+    std::clog << "Succeeded. \n";
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2024 Martin Werner Licht
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cassert>
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+#include "steiner.hpp"
+
+// check that the edges form a spanning tree of the points 
+bool is_spanning_tree( const std::vector<PlanarPoint>& points, const std::vector<std::pair<int,int>>& tree )
+{
+    if( tree.size() + 1 != points.size() ) return false;
+
+    std::vector<int> component( points.size() );
+    for( int i = 0; i < points.size(); i++ ) component[i] = i;
+
+    for( const auto& edge : tree )
+    {
+        const int a = component[edge.first];
+        const int b = component[edge.second];
+        if( a == b ) return false;
+        for( auto& c : component ) if( c == b ) c = a;
+    }
+
+    return true;
+}
+
+int main()
+{
+    // three pins: the median point is the Steiner point 
+    {
+        std::vector<PlanarPoint> points = { { 0, 0 }, { 10, 2 }, { 4, 8 } };
+        const auto tree = rectilinear_steiner_tree( points );
+        assert( points.size() == 4 );
+        assert( points[3] == PlanarPoint( 4, 2 ) );
+        assert( is_spanning_tree( points, tree ) );
+        assert( tree_length( points, tree ) == 18 );
+    }
+
+    // four pins at the corners of a square: the spanning tree has length 30, the Steiner tree has length 20 + 10 
+    {
+        std::vector<PlanarPoint> points = { { 0, 0 }, { 10, 0 }, { 0, 10 }, { 10, 10 } };
+        assert( tree_length( points, rectilinear_spanning_tree( points ) ) == 30 );
+        const auto tree = rectilinear_steiner_tree( points );
+        assert( is_spanning_tree( points, tree ) );
+        assert( tree_length( points, tree ) == 30 );
+    }
+
+    // a cross: one Steiner point in the middle 
+    {
+        std::vector<PlanarPoint> points = { { 5, 0 }, { 0, 5 }, { 10, 5 }, { 5, 10 } };
+        const auto tree = rectilinear_steiner_tree( points );
+        assert( is_spanning_tree( points, tree ) );
+        assert( tree_length( points, tree ) == 20 );
+        assert( points.size() == 5 and points[4] == PlanarPoint( 5, 5 ) );
+    }
+
+    // random nets: the Steiner tree is never longer than the spanning tree, 
+    // and large nets fall back to the spanning tree 
+    std::mt19937 generator( 42 );
+
+    for( int num_pins = 1; num_pins <= 12; num_pins++ )
+    for( int trial = 0; trial < 20; trial++ )
+    {
+        std::set<PlanarPoint> distinct;
+        while( distinct.size() < num_pins ) distinct.insert( { generator() % 30, generator() % 30 } );
+
+        std::vector<PlanarPoint> points( distinct.begin(), distinct.end() );
+
+        const int spanning_length = tree_length( points, rectilinear_spanning_tree( points ) );
+
+        const auto tree = rectilinear_steiner_tree( points );
+
+        assert( is_spanning_tree( points, tree ) );
+        assert( tree_length( points, tree ) <= spanning_length );
+        if( num_pins > 8 ) assert( points.size() == num_pins );
+    }
+
+    std::clog << "Succeeded. \n";
+
+    return 0;
+}